@@ -1,220 +1,320 @@
+#include <chrono>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 #include <string>
-#include <sstream>
-#include <cmath>
-
-// Класс для представления 32-битного бинарного числа
-class Binary {
-    static const int BINARY_SIZE = 32; // Размер бинарного числа
-    char bits[BINARY_SIZE]; // Массив для хранения битов бинарного числа
-    int decimal; // Десятичное представление числа
-
-    // Функция для инвертирования всех битов (дополнение до 1)
-    void negate() {
-        for (int i = 0; i < BINARY_SIZE; i++) {
-            bits[i] = 1 - bits[i];
-        }
-    }
-
-    // Функция для сдвига битов влево на заданное количество позиций
-    void shift_bits(unsigned int shift) {
-        for (int i = 0; i < BINARY_SIZE - shift; i++) {
-            bits[i] = bits[i + shift];
-        }
-        for (int i = BINARY_SIZE - shift; i < BINARY_SIZE; i++) {
-            bits[i] = 0;
+#include <string_view>
+#include <utility>
+#include "binary.h"
+#include "bigbinary.h"
+#include "batch.h"
+#include "tokenizer.h"
+#include "bytecode.h"
+#include "columnar.h"
+#include "operand_stack.h"
+#include "memo.h"
+#include "bitslice.h"
+#include "infix.h"
+#include "instrument.h"
+#include "operators.h"
+#include "server.h"
+#include "pipeline.h"
+#include "format.h"
+#include "jit.h"
+#include "evaluation.h"
+#include "streaming.h"
+#include "forkjoin.h"
+#include "program.h"
+#include "constant.h"
+
+// Функция для обработки постфиксного выражения без исключений:
+// ошибка во входе возвращается вместе с местом, где она найдена
+template <class Number>
+EvaluationResult<Number> tryEvaluatePostfix(std::string_view expression) {
+    INSTRUMENT_PHASE(evaluateNanos);
+    Tokenizer tokenizer(expression);
+    std::string_view token;
+    thread_local OperandStack<Number> stack;
+    stack.clear();
+
+    while (tokenizer.next(token)) {
+        char op = binaryOperatorCode(token);
+        if (op != 0) { 
+            if (stack.size() < 2) return evaluationError(EVALUATION_STACK_UNDERFLOW, expression, token);
+            Number b = stack.pop();
+            Number a = stack.pop();
+
+            Number result;
+            EvaluationErrorCode code = tryApplyBinaryOperator(op, a, b, result);
+            if (code != EVALUATION_OK) return evaluationError(code, expression, token);
+            stack.push(std::move(result));
+            
+        } else if (isNotOperator(token)) {
+            if (stack.isEmpty()) return evaluationError(EVALUATION_STACK_UNDERFLOW, expression, token);
+            stack.push(~stack.pop());
+        } else { 
+            int value;
+            if (!parseInt(token, value)) return evaluationError(EVALUATION_BAD_TOKEN, expression, token);
+            Number number;
+            EvaluationErrorCode code = tryMakeNumber(value, number);
+            if (code != EVALUATION_OK) return evaluationError(code, expression, token);
+            stack.push(std::move(number));
         }
-        decimal <<= shift;
     }
 
-public:
-    // Конструктор по умолчанию
-    Binary() : decimal(0) {
-        for (int i = 0; i < BINARY_SIZE; i++) {
-            bits[i] = 0;
-        }
-    }
+    if (stack.isEmpty()) return evaluationErrorAtEnd(EVALUATION_STACK_UNDERFLOW, expression);
+    
+    Number result = stack.pop();
+    
+    if (!stack.isEmpty()) return evaluationErrorAtEnd(EVALUATION_LEFTOVER_OPERANDS, expression);
 
-    // Конструктор с параметром - десятичное число
-    Binary(int _decimal) : decimal(_decimal) {
-        bool negative = decimal < 0;
-        int abs_decimal = std::abs(decimal);
+    return result;
+}
 
-        for (int i = BINARY_SIZE - 1; i >= 0; i--) {
-            bits[i] = abs_decimal % 2;
-            abs_decimal /= 2;
-        }
+// Функция для обработки постфиксного выражения (ошибка - исключение)
+template <class Number>
+Number evaluatePostfix(std::string_view expression) {
+    EvaluationResult<Number> result = tryEvaluatePostfix<Number>(expression);
+    if (!result) throw std::runtime_error(result.error().message());
+    return std::move(result.value());
+}
 
-        if (negative) {
-            negate();
-            *this = *this + Binary(1);
-            decimal--;
-        }
-    }
+// Пакетный режим с кэшем вычислений
+template <class Number>
+void runMemoizedBatch(const std::string& inputFile, bool parallel, FormatMode mode) {
+    MemoizedEvaluator<Number> evaluator;
+    BatchStats stats = runBatchInput(inputFile, std::cout, parallel, evaluator, mode);
+    printBatchStats(std::cerr, stats);
+    printMemoStats(std::cerr, evaluator);
+}
 
-    // Оператор присваивания
-    Binary& operator=(const Binary& other) {
-        if (this != &other) {
-            for (int i = 0; i < BINARY_SIZE; i++) {
-                bits[i] = other.bits[i];
-            }
-            decimal = other.decimal;
-        }
-        return *this;
-    }
+// Вычисление одного большого выражения с параллельным вычислением
+// независимых поддеревьев. Некорректное выражение вычисляется обычным
+// способом, чтобы ошибка была той же, что и у tryEvaluatePostfix
+template <class Number>
+EvaluationResult<Number> tryEvaluateForkJoin(std::string_view expression, WorkStealingPool& pool) {
+    PostfixTree tree;
+    if (!tree.parse(expression, pool)) return tryEvaluatePostfix<Number>(expression);
+    return tree.evaluate<Number>(pool);
+}
 
-    // Оператор вывода в поток
-    friend std::ostream& operator<<(std::ostream& os, const Binary& b) {
-        for (int i = 0; i < BINARY_SIZE; i++) {
-            os << (int)b.bits[i];
-        }
-        os << " (" << b.decimal << ")";
-        return os;
+// Режим одного большого выражения из файла (весь файл - одно выражение)
+// или стандартного ввода, вычисляемого на всех ядрах
+template <class Number>
+void runForkJoin(const std::string& inputFile) {
+    auto start = std::chrono::steady_clock::now();
+    WorkStealingPool pool;
+    EvaluationResult<Number> result = Number();
+    if (!inputFile.empty()) {
+        MappedFile mapped(inputFile);
+        result = tryEvaluateForkJoin<Number>(mapped.view(), pool);
+    } else {
+        std::string text((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+        result = tryEvaluateForkJoin<Number>(text, pool);
     }
-
-    // Оператор сложения
-    Binary operator+(const Binary& other) const {
-        Binary result;
-        int carry = 0;
-        for (int i = BINARY_SIZE - 1; i >= 0; i--) {
-            int sum = this->bits[i] + other.bits[i] + carry;
-            result.bits[i] = sum % 2;
-            carry = sum / 2;
-        }
-        result.decimal = this->decimal + other.decimal;
-        return result;
+    if (!result) {
+        throw std::runtime_error(result.error().message() + " (offset " + std::to_string(result.error().offset) + ")");
     }
+    std::cout << "Result: " << result.value() << std::endl;
+    std::cerr << "Evaluated on " << pool.size() << " threads in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+}
 
-    // Унарный оператор минус (инвертирование)
-    Binary operator-() const {
-        Binary result(*this);
-        result.negate();
-        result = result + Binary(1);
-        result.decimal = -decimal;
-        return result;
+// Потоковое вычисление одного выражения любой длины: память зависит только
+// от глубины стека. С путем checkpoint состояние периодически сохраняется,
+// и прерванное вычисление при следующем запуске продолжается с этого места
+template <class Number>
+void runStreaming(const std::string& inputFile, const std::string& checkpoint) {
+    StreamingEvaluator<Number> evaluator;
+    EvaluationResult<Number> result = evaluateStreamInput(inputFile, evaluator, checkpoint);
+    if (!result) {
+        throw std::runtime_error(result.error().message() + " (offset " + std::to_string(result.error().offset) + ")");
     }
+    std::cout << "Result: " << result.value() << std::endl;
+    std::cerr << "Streamed " << evaluator.consumed() << " bytes, " << evaluator.tokenCount()
+              << " tokens, max stack depth " << evaluator.maxStackDepth() << std::endl;
+}
 
-    // Оператор вычитания
-    Binary operator-(const Binary& other) const {
-        return *this + (-other);
-    }
+// Режим сервера: выражения приходят по локальному сокету, с --memo
+// кэш вычислений сохраняется между запросами всех клиентов
+template <class Number>
+void runEvaluatorServer(const std::string& path, bool memo) {
+#ifdef __linux__
+    ServerStats stats = memo ? runServer(path, MemoizedEvaluator<Number>()) : runServer(path, tryEvaluatePostfix<Number>);
+    printServerStats(std::cerr, stats);
+#else
+    (void)path;
+    (void)memo;
+    throw std::runtime_error("Server mode is supported only on Linux");
+#endif
+}
 
-    // Оператор умножения
-    Binary operator*(const Binary& other) const {
-        Binary result;
-        for (int i = 0; i < BINARY_SIZE; ++i) {
-            if (other.bits[BINARY_SIZE - 1 - i]) {
-                Binary temp(*this);
-                temp.shift_bits(i);
-                result = result + temp;
-            }
-        }
-        return result;
-    }
-};
-
-// Узел связного списка
-struct Node {
-    Binary data; // Данные типа Binary
-    Node* next; // Указатель на следующий узел
-
-    // Конструктор узла
-    Node(Binary data) : data(data), next(nullptr) {}
-};
-
-// Реализация стека на основе связного списка
-class Stack {
-private:
-    Node* top; // Указатель на вершину стека
-
-public:
-    // Конструктор по умолчанию
-    Stack() : top(nullptr) {}
-
-    // Деструктор для очистки памяти
-    ~Stack() {
-        while (!isEmpty()) {
-            pop();
+// Без main файл подключается как библиотека вычислителей (например, в bench.cpp)
+#ifndef POSTFIX_NO_MAIN
+int main(int argc, char* argv[]) {
+    try {
+        
+        // Ключ --big включает вычисление с произвольной точностью,
+        // ключ --batch [файл] - пакетный режим, --parallel - на всех ядрах,
+        // --formula "x y + 3 *" [файл] - формула с переменными, строки входа - их значения,
+        // --columnar - формула вычисляется векторно по столбцам значений,
+        // --memo - пакетный режим с кэшем выражений и подвыражений,
+        // --bitsliced - формула или выражения одной формы вычисляются по 64 на битовых срезах,
+        // --infix - выражения в инфиксной записи со скобками,
+        // --serve путь - сервер вычислений на локальном сокете (до Ctrl+C),
+        // --pipelined - пакетный режим конвейером: чтение, разбор и вычисление в разных потоках,
+        // --format binary|hex|decimal - вид вывода результатов в пакетном режиме,
+        // --jit - формула компилируется в машинный код x86-64,
+        // --stream [файл] - одно выражение любой длины читается кусками,
+        // --checkpoint путь - контрольная точка потокового вычисления,
+        // --forkjoin [файл] - одно большое выражение, поддеревья вычисляются параллельно,
+        // --write-program путь - выражения пакетного входа переводятся в двоичные программы,
+        // --program [файл] - пакетный режим на файле двоичных программ
+        bool big = false;
+        bool batch = false;
+        bool parallel = false;
+        bool columnar = false;
+        bool memo = false;
+        bool bitsliced = false;
+        bool infix = false;
+        bool pipelined = false;
+        FormatMode mode = FORMAT_BINARY;
+        bool jit = false;
+        bool stream = false;
+        bool forkjoin = false;
+        bool program = false;
+        std::string programFile;
+        std::string checkpoint;
+        std::string formula;
+        std::string socketPath;
+        std::string inputFile;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--big") big = true;
+            else if (arg == "--batch") batch = true;
+            else if (arg == "--parallel") parallel = true;
+            else if (arg == "--formula" && i + 1 < argc) formula = argv[++i];
+            else if (arg == "--columnar") columnar = true;
+            else if (arg == "--memo") memo = true;
+            else if (arg == "--bitsliced") bitsliced = true;
+            else if (arg == "--infix") infix = true;
+            else if (arg == "--serve" && i + 1 < argc) socketPath = argv[++i];
+            else if (arg == "--pipelined") pipelined = true;
+            else if (arg == "--format" && i + 1 < argc) mode = parseFormatMode(argv[++i]);
+            else if (arg == "--jit") jit = true;
+            else if (arg == "--stream") stream = true;
+            else if (arg == "--forkjoin") forkjoin = true;
+            else if (arg == "--write-program" && i + 1 < argc) programFile = argv[++i];
+            else if (arg == "--program") program = true;
+            else if (arg == "--checkpoint" && i + 1 < argc) checkpoint = argv[++i];
+            else inputFile = arg;
         }
-    }
-
-    // Функция для добавления элемента в стек
-    void push(Binary value) {
-        Node* newNode = new Node(value);
-        newNode->next = top;
-        top = newNode;
-    }
 
-    // Функция для удаления элемента из стека
-    Binary pop() {
-        if (isEmpty()) {
-            throw std::runtime_error("Stack is empty");
+        if (!socketPath.empty()) {
+            if (big) runEvaluatorServer<BigBinary>(socketPath, memo);
+            else runEvaluatorServer<Binary32>(socketPath, memo);
+            return 0;
         }
-        Binary value = top->data;
-        Node* temp = top;
-        top = top->next;
-        delete temp;
-        return value;
-    }
 
-    // Функция для проверки, пуст ли стек
-    bool isEmpty() const {
-        return top == nullptr;
-    }
-};
+        if (forkjoin) {
+            std::ios::sync_with_stdio(false);
+            if (big) runForkJoin<BigBinary>(inputFile);
+            else runForkJoin<Binary32>(inputFile);
+            return 0;
+        }
 
-// Функция для обработки постфиксного выражения
-Binary evaluatePostfix(const std::string& expression) {
-    std::istringstream iss(expression);
-    std::string token;
-    Stack stack;
+        if (stream) {
+            std::ios::sync_with_stdio(false);
+            if (big) runStreaming<BigBinary>(inputFile, checkpoint);
+            else runStreaming<Binary32>(inputFile, checkpoint);
+            return 0;
+        }
 
-    while (iss >> token) {
-        if (token == "+" || token == "-" || token == "*") { 
-            if (stack.isEmpty()) throw std::runtime_error("Invalid expression");
-            Binary b = stack.pop();
+        if (!programFile.empty()) {
+            std::ios::sync_with_stdio(false);
+            printBatchStats(std::cerr, writeProgramsInput(inputFile, programFile));
+            return 0;
+        }
 
-            if (stack.isEmpty()) throw std::runtime_error("Invalid expression");
-            Binary a = stack.pop();
+        if (program) {
+            std::ios::sync_with_stdio(false);
+            BatchStats stats = big ? runProgramInput<BigBinary>(inputFile, std::cout, parallel, mode)
+                                   : runProgramInput<Binary32>(inputFile, std::cout, parallel, mode);
+            printBatchStats(std::cerr, stats);
+            return 0;
+        }
 
-            if (token == "+") stack.push(a + b);
-            else if (token == "-") stack.push(a - b);
-            else if (token == "*") stack.push(a * b);
-            
-        } else { 
-            try { 
-                int value = std::stoi(token); 
-                stack.push(Binary(value));
-            } catch (...) { 
-                throw std::runtime_error("Invalid token: " + token);
+        if (!formula.empty()) {
+            std::ios::sync_with_stdio(false);
+            if (columnar && !big) {
+                BatchStats stats = runColumnarInput(inputFile, std::cout, CompiledExpression<Binary32>::compile(formula), mode);
+                printBatchStats(std::cerr, stats);
+                return 0;
             }
+            if (bitsliced && !big) {
+                BatchStats stats = runBitSlicedInput(inputFile, std::cout, CompiledExpression<Binary32>::compile(formula), mode);
+                printBatchStats(std::cerr, stats);
+                return 0;
+            }
+            if (jit && !big) {
+                BatchStats stats = runBatchInput(inputFile, std::cout, parallel, JitFormulaEvaluator<Binary32>(CompiledExpression<Binary32>::compile(formula)), mode);
+                printBatchStats(std::cerr, stats);
+                return 0;
+            }
+            BatchStats stats = big
+                ? runBatchInput(inputFile, std::cout, parallel, FormulaEvaluator<BigBinary>(CompiledExpression<BigBinary>::compile(formula)), mode)
+                : runBatchInput(inputFile, std::cout, parallel, FormulaEvaluator<Binary32>(CompiledExpression<Binary32>::compile(formula)), mode);
+            printBatchStats(std::cerr, stats);
+            return 0;
         }
-    }
 
-    if (stack.isEmpty()) throw std::runtime_error("Invalid expression");
-    
-    Binary result = stack.pop();
-    
-    if (!stack.isEmpty()) throw std::runtime_error("Invalid expression");
-
-    return result;
-}
+        if (batch) {
+            std::ios::sync_with_stdio(false);
+            if (infix) {
+                BatchStats stats = big ? runBatchInput(inputFile, std::cout, parallel, evaluateInfix<BigBinary>, mode)
+                                       : runBatchInput(inputFile, std::cout, parallel, evaluateInfix<Binary32>, mode);
+                printBatchStats(std::cerr, stats);
+                return 0;
+            }
+            if (memo) {
+                if (big) runMemoizedBatch<BigBinary>(inputFile, parallel, mode);
+                else runMemoizedBatch<Binary32>(inputFile, parallel, mode);
+                return 0;
+            }
+            if (bitsliced && !big) {
+                BatchStats stats = runBitSlicedBatchInput<Binary32>(inputFile, std::cout, evaluatePostfix<Binary32>, mode);
+                printBatchStats(std::cerr, stats);
+                return 0;
+            }
+            if (pipelined) {
+                PipelineStats pipeline;
+                BatchStats stats = big ? runPipelinedInput<BigBinary>(inputFile, std::cout, pipeline, mode)
+                                       : runPipelinedInput<Binary32>(inputFile, std::cout, pipeline, mode);
+                printBatchStats(std::cerr, stats);
+                printPipelineStats(std::cerr, pipeline);
+                return 0;
+            }
+            // Файл отображается в память и разбирается без копирования
+            BatchStats stats = big ? runBatchInput(inputFile, std::cout, parallel, tryEvaluatePostfix<BigBinary>, mode)
+                                   : runBatchInput(inputFile, std::cout, parallel, tryEvaluatePostfix<Binary32>, mode);
+            printBatchStats(std::cerr, stats);
+            return 0;
+        }
 
-int main() {
-    try {
-        
         std::string expression;
         
-        std::cout << "Enter a postfix expression: ";
+        std::cout << (infix ? "Enter an infix expression: " : "Enter a postfix expression: ");
         
         std::getline(std::cin, expression);
 
         
-        Binary result = evaluatePostfix(expression);
-
-        
-        std::cout << "Result: " << result << std::endl;
+        if (big) {
+            BigBinary result = infix ? evaluateInfix<BigBinary>(expression) : evaluatePostfix<BigBinary>(expression);
+            std::cout << "Result: " << result << std::endl;
+        } else {
+            Binary32 result = infix ? evaluateInfix<Binary32>(expression) : evaluatePostfix<Binary32>(expression);
+            std::cout << "Result: " << result << std::endl;
+        }
 
         
     } catch (const std::exception& e) {
@@ -225,4 +325,5 @@ int main() {
 
     
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -1,221 +1,299 @@
+#include <chrono>    // Подключение замера времени
 #include <iostream>  // Подключение библиотеки для ввода-вывода
+#include <iterator>  // Подключение чтения потока целиком
 #include <stdexcept> // Подключение библиотеки для обработки исключений
 #include <string>    // Подключение библиотеки для работы со строками
-#include <sstream>   // Подключение библиотеки для работы с потоками строк
-#include <cmath>     // Подключение библиотеки для математических операций
-
-// Класс для представления 32-битного бинарного числа
-class Binary {
-    static const int BINARY_SIZE = 32; // Размер бинарного числа (32 бита)
-    char bits[BINARY_SIZE]; // Массив для хранения битов бинарного числа
-    int decimal; // Десятичное представление числа
-
-    // Функция для инвертирования всех битов (дополнение до 1)
-    void negate() {
-        for (int i = 0; i < BINARY_SIZE; i++) {
-            bits[i] = 1 - bits[i]; // Инвертирование каждого бита
-        }
-    }
-
-    // Функция для сдвига битов влево на заданное количество позиций
-    void shift_bits(unsigned int shift) {
-        for (int i = 0; i < BINARY_SIZE - shift; i++) {
-            bits[i] = bits[i + shift]; // Сдвиг битов влево
-        }
-        for (int i = BINARY_SIZE - shift; i < BINARY_SIZE; i++) {
-            bits[i] = 0; // Заполнение освободившихся битов нулями
+#include <string_view> // Подключение представления строки без копирования
+#include <utility>   // Подключение std::move
+#include "binary.h"  // Подключение шаблона бинарного числа
+#include "bigbinary.h" // Подключение числа произвольной точности
+#include "batch.h"     // Подключение пакетного режима
+#include "tokenizer.h" // Подключение разбора на токены без копирования
+#include "bytecode.h"  // Подключение компиляции выражения в байт-код
+#include "columnar.h"  // Подключение столбцового векторного вычислителя
+#include "operand_stack.h" // Подключение стека операндов без выделений памяти
+#include "memo.h"      // Подключение кэша вычислений
+#include "bitslice.h"  // Подключение вычислителя на битовых срезах
+#include "infix.h"     // Подключение вычисления инфиксных выражений
+#include "instrument.h" // Подключение необязательных счетчиков производительности
+#include "operators.h" // Подключение кодов операций и их применения
+#include "server.h"    // Подключение сервера вычислений на локальном сокете
+#include "pipeline.h"  // Подключение конвейерного пакетного режима
+#include "format.h"    // Подключение быстрого вывода результатов по таблицам
+#include "jit.h"       // Подключение компиляции формулы в машинный код
+#include "evaluation.h" // Подключение вычисления без исключений
+#include "streaming.h"  // Подключение потокового вычисления с контрольными точками
+#include "forkjoin.h"   // Подключение параллельного вычисления одного большого выражения
+#include "program.h"    // Подключение двоичного формата разобранных программ
+#include "constant.h"   // Подключение вычисления выражений-литералов при компиляции
+
+// Функция для обработки постфиксного выражения без исключений
+template <class Number>
+EvaluationResult<Number> tryEvaluatePostfix(std::string_view expression) {
+    INSTRUMENT_PHASE(evaluateNanos); // Замер времени вычисления (только при сборке с -DPOSTFIX_INSTRUMENT)
+    Tokenizer tokenizer(expression);  // Разбор выражения на токены прямо по исходным байтам
+    std::string_view token; // Текущий токен (участок исходной строки, без копирования)
+    thread_local OperandStack<Number> stack; // Стек операндов потока, его буфер переиспользуется между выражениями
+    stack.clear(); // Очистка стека с сохранением емкости
+
+    while (tokenizer.next(token)) {  // Цикл по каждому токену в выражении
+        char op = binaryOperatorCode(token); // Код бинарной операции (0 - не операция)
+        if (op != 0) {  // Если токен бинарный оператор
+            if (stack.size() < 2) return evaluationError(EVALUATION_STACK_UNDERFLOW, expression, token); // Проверка наличия двух операндов
+            Number b = stack.pop();  // Извлечение второго операнда
+            Number a = stack.pop();  // Извлечение первого операнда
+
+            Number result;
+            EvaluationErrorCode code = tryApplyBinaryOperator(op, a, b, result); // Выполнение операции без исключений
+            if (code != EVALUATION_OK) return evaluationError(code, expression, token); // Переполнение, деление на ноль или неверный сдвиг
+            stack.push(std::move(result)); // Добавление результата в стек
+            
+        } else if (isNotOperator(token)) { // Если токен побитовое НЕ
+            if (stack.isEmpty()) return evaluationError(EVALUATION_STACK_UNDERFLOW, expression, token); // Проверка наличия операнда
+            stack.push(~stack.pop()); // Инвертирование битов вершины стека
+        } else {  // Если токен операнд
+            int value;
+            if (!parseInt(token, value)) return evaluationError(EVALUATION_BAD_TOKEN, expression, token); // Некорректный операнд
+            Number number;
+            EvaluationErrorCode code = tryMakeNumber(value, number); // Проверка, что число помещается в тип
+            if (code != EVALUATION_OK) return evaluationError(code, expression, token);
+            stack.push(std::move(number)); // Добавление операнда в стек
         }
-        decimal <<= shift; // Сдвиг десятичного представления влево
     }
 
-public:
-    // Конструктор по умолчанию
-    Binary() : decimal(0) {
-        for (int i = 0; i < BINARY_SIZE; i++) {
-            bits[i] = 0; // Инициализация всех битов нулями
-        }
-    }
+    if (stack.isEmpty()) return evaluationErrorAtEnd(EVALUATION_STACK_UNDERFLOW, expression); // Пустое выражение
+    
+    Number result = stack.pop(); // Получение конечного результата
+    
+    if (!stack.isEmpty()) return evaluationErrorAtEnd(EVALUATION_LEFTOVER_OPERANDS, expression); // Лишние операнды
 
-    // Конструктор с параметром - десятичное число
-    Binary(int _decimal) : decimal(_decimal) {
-        bool negative = decimal < 0; // Проверка, является ли число отрицательным
-        int abs_decimal = std::abs(decimal); // Абсолютное значение числа
+    return result; // Возвращение итогового результата
+}
 
-        for (int i = BINARY_SIZE - 1; i >= 0; i--) {
-            bits[i] = abs_decimal % 2; // Преобразование числа в двоичный вид
-            abs_decimal /= 2;
-        }
+// Функция для обработки постфиксного выражения (ошибка - исключение)
+template <class Number>
+Number evaluatePostfix(std::string_view expression) {
+    EvaluationResult<Number> result = tryEvaluatePostfix<Number>(expression); // Вычисление без исключений
+    if (!result) throw std::runtime_error(result.error().message()); // Ошибка превращается в исключение с прежним текстом
+    return std::move(result.value()); // Возвращение итогового результата
+}
 
-        if (negative) {
-            negate(); // Инвертирование битов для отрицательных чисел
-            *this = *this + Binary(1); // Добавление единицы для получения дополнительного кода
-            decimal--; // Коррекция десятичного значения
-        }
-    }
+// Пакетный режим с кэшем вычислений
+template <class Number>
+void runMemoizedBatch(const std::string& inputFile, bool parallel, FormatMode mode) {
+    MemoizedEvaluator<Number> evaluator; // Вычислитель с кэшем выражений и подвыражений
+    BatchStats stats = runBatchInput(inputFile, std::cout, parallel, evaluator, mode); // Вычисление всех выражений
+    printBatchStats(std::cerr, stats); // Вывод пропускной способности
+    printMemoStats(std::cerr, evaluator); // Вывод попаданий и промахов кэша
+}
 
-    // Оператор присваивания
-    Binary& operator=(const Binary& other) {
-        if (this != &other) { // Проверка на самоприсваивание
-            for (int i = 0; i < BINARY_SIZE; i++) {
-                bits[i] = other.bits[i]; // Копирование битов
-            }
-            decimal = other.decimal; // Копирование десятичного значения
-        }
-        return *this;
-    }
+// Вычисление одного большого выражения с параллельным вычислением независимых поддеревьев
+template <class Number>
+EvaluationResult<Number> tryEvaluateForkJoin(std::string_view expression, WorkStealingPool& pool) {
+    PostfixTree tree; // Компактное дерево: узлы в постфиксном порядке с размерами поддеревьев
+    if (!tree.parse(expression, pool)) return tryEvaluatePostfix<Number>(expression); // Некорректное выражение - обычным способом, с той же ошибкой
+    return tree.evaluate<Number>(pool); // Большие поддеревья параллельно, малые последовательно
+}
 
-    // Оператор вывода в поток
-    friend std::ostream& operator<<(std::ostream& os, const Binary& b) {
-        for (int i = 0; i < BINARY_SIZE; i++) {
-            os << (int)b.bits[i]; // Вывод битов в поток
-        }
-        os << " (" << b.decimal << ")"; // Вывод десятичного представления числа
-        return os;
+// Режим одного большого выражения на всех ядрах
+template <class Number>
+void runForkJoin(const std::string& inputFile) {
+    auto start = std::chrono::steady_clock::now(); // Начало замера времени
+    WorkStealingPool pool; // Пул потоков по числу ядер
+    EvaluationResult<Number> result = Number();
+    if (!inputFile.empty()) { // Весь файл - одно выражение, отображается в память
+        MappedFile mapped(inputFile);
+        result = tryEvaluateForkJoin<Number>(mapped.view(), pool);
+    } else { // Выражение читается из стандартного ввода целиком
+        std::string text((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+        result = tryEvaluateForkJoin<Number>(text, pool);
     }
-
-    // Оператор сложения
-    Binary operator+(const Binary& other) const {
-        Binary result;
-        int carry = 0; // Перенос при сложении битов
-        for (int i = BINARY_SIZE - 1; i >= 0; i--) {
-            int sum = this->bits[i] + other.bits[i] + carry; // Сложение битов и переноса
-            result.bits[i] = sum % 2; // Результирующий бит
-            carry = sum / 2; // Новый перенос
-        }
-        result.decimal = this->decimal + other.decimal; // Сложение десятичных значений
-        return result;
+    if (!result) { // Ошибка с местом в выражении
+        throw std::runtime_error(result.error().message() + " (offset " + std::to_string(result.error().offset) + ")");
     }
+    std::cout << "Result: " << result.value() << std::endl; // Вывод результата
+    std::cerr << "Evaluated on " << pool.size() << " threads in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl; // Вывод времени
+}
 
-    // Унарный оператор минус (инвертирование)
-    Binary operator-() const {
-        Binary result(*this); // Создание копии текущего объекта
-        result.negate(); // Инвертирование битов
-        result = result + Binary(1); // Добавление единицы для получения дополнительного кода
-        result.decimal = -decimal; // Инвертирование десятичного значения
-        return result;
+// Потоковое вычисление одного выражения любой длины с контрольными точками
+template <class Number>
+void runStreaming(const std::string& inputFile, const std::string& checkpoint) {
+    StreamingEvaluator<Number> evaluator; // Хранит только стек и начало разрезанного токена
+    EvaluationResult<Number> result = evaluateStreamInput(inputFile, evaluator, checkpoint); // Чтение кусками, восстановление из точки
+    if (!result) { // Ошибка с местом в выражении
+        throw std::runtime_error(result.error().message() + " (offset " + std::to_string(result.error().offset) + ")");
     }
+    std::cout << "Result: " << result.value() << std::endl; // Вывод результата
+    std::cerr << "Streamed " << evaluator.consumed() << " bytes, " << evaluator.tokenCount()
+              << " tokens, max stack depth " << evaluator.maxStackDepth() << std::endl; // Вывод объема входа и глубины стека
+}
 
-    // Оператор вычитания
-    Binary operator-(const Binary& other) const {
-        return *this + (-other); // Вычитание через сложение с инверсией второго операнда
-    }
+// Режим сервера: выражения приходят по локальному сокету, с --memo
+// кэш вычислений сохраняется между запросами всех клиентов
+template <class Number>
+void runEvaluatorServer(const std::string& path, bool memo) {
+#ifdef __linux__ // Сервер использует epoll, eventfd и signalfd - только Linux
+    ServerStats stats = memo ? runServer(path, MemoizedEvaluator<Number>()) : runServer(path, tryEvaluatePostfix<Number>); // Работа до SIGINT или SIGTERM
+    printServerStats(std::cerr, stats); // Вывод числа соединений и выражений
+#else
+    (void)path;
+    (void)memo;
+    throw std::runtime_error("Server mode is supported only on Linux"); // На других системах режима нет
+#endif
+}
 
-    // Оператор умножения
-    Binary operator*(const Binary& other) const {
-        Binary result;
-        for (int i = 0; i < BINARY_SIZE; ++i) {
-            if (other.bits[BINARY_SIZE - 1 - i]) { // Проверка бита множителя на единицу
-                Binary temp(*this); 
-                temp.shift_bits(i); 
-                result = result + temp;
-            }
-        }
-        return result;
-    }
-};
-
-// Узел связного списка
-struct Node {
-    Binary data; // Данные типа Binary
-    Node* next; // Указатель на следующий узел
-
-    // Конструктор узла
-    Node(Binary data) : data(data), next(nullptr) {}
-};
-
-// Реализация стека на основе связного списка
-class Stack {
-private:
-    Node* top; // Указатель на вершину стека
-
-public:
-    // Конструктор по умолчанию
-    Stack() : top(nullptr) {}
-
-    // Деструктор для очистки памяти
-    ~Stack() {
-        while (!isEmpty()) { 
-            pop(); 
+// Без main файл подключается как библиотека вычислителей (например, в bench.cpp)
+#ifndef POSTFIX_NO_MAIN
+int main(int argc, char* argv[]) {
+    
+    try {
+        
+        bool big = false; // Ключ --big включает вычисление с произвольной точностью
+        bool batch = false; // Ключ --batch включает пакетный режим
+        bool parallel = false; // Ключ --parallel включает вычисление на всех ядрах
+        bool columnar = false; // Ключ --columnar включает столбцовый режим для формулы
+        bool memo = false; // Ключ --memo включает кэш вычислений в пакетном режиме
+        bool bitsliced = false; // Ключ --bitsliced включает вычисление по 64 выражения на битовых срезах
+        bool infix = false; // Ключ --infix включает инфиксную запись выражений
+        bool pipelined = false; // Ключ --pipelined включает конвейер из трех потоков в пакетном режиме
+        FormatMode mode = FORMAT_BINARY; // Ключ --format binary|hex|decimal - вид вывода результатов в пакетном режиме
+        bool jit = false; // Ключ --jit включает компиляцию формулы в машинный код x86-64
+        bool stream = false; // Ключ --stream [файл] - одно выражение любой длины читается кусками
+        bool forkjoin = false; // Ключ --forkjoin [файл] - одно большое выражение вычисляется на всех ядрах
+        bool program = false; // Ключ --program [файл] - пакетный режим на файле двоичных программ
+        std::string programFile; // Ключ --write-program путь - перевод выражений пакетного входа в двоичные программы
+        std::string checkpoint; // Ключ --checkpoint путь - файл контрольной точки потокового вычисления
+        std::string formula; // Ключ --formula "x y + 3 *" - формула с переменными, строки входа - их значения
+        std::string socketPath; // Ключ --serve путь - сервер вычислений на локальном сокете
+        std::string inputFile; // Файл с выражениями для пакетного режима
+        for (int i = 1; i < argc; i++) { // Разбор аргументов командной строки
+            std::string arg = argv[i];
+            if (arg == "--big") big = true;
+            else if (arg == "--batch") batch = true;
+            else if (arg == "--parallel") parallel = true;
+            else if (arg == "--formula" && i + 1 < argc) formula = argv[++i];
+            else if (arg == "--columnar") columnar = true; // Формула вычисляется векторно по столбцам значений
+            else if (arg == "--memo") memo = true; // Повторяющиеся выражения и подвыражения берутся из кэша
+            else if (arg == "--bitsliced") bitsliced = true; // Формула или выражения одной формы вычисляются по 64 сразу
+            else if (arg == "--infix") infix = true; // Выражения вида "2 * (3 + -4)"
+            else if (arg == "--serve" && i + 1 < argc) socketPath = argv[++i]; // Работа до Ctrl+C, клиенты подключаются к сокету
+            else if (arg == "--pipelined") pipelined = true; // Чтение, разбор и вычисление работают одновременно
+            else if (arg == "--format" && i + 1 < argc) mode = parseFormatMode(argv[++i]); // Биты, шестнадцатеричное или только десятичное число
+            else if (arg == "--jit") jit = true; // На других платформах формулу вычисляет интерпретатор байт-кода
+            else if (arg == "--stream") stream = true; // Память зависит от глубины стека, а не от длины выражения
+            else if (arg == "--forkjoin") forkjoin = true; // Независимые большие поддеревья вычисляются параллельно
+            else if (arg == "--write-program" && i + 1 < argc) programFile = argv[++i]; // Файл, в который пишутся программы
+            else if (arg == "--program") program = true; // Вход уже разобран на токены
+            else if (arg == "--checkpoint" && i + 1 < argc) checkpoint = argv[++i]; // Если файл есть, вычисление продолжается с него
+            else inputFile = arg;
         }
-    }
-
-    // Функция для добавления элемента в стек
-    void push(Binary value) { 
-        Node* newNode = new Node(value);  // Создание нового узла
-        newNode->next = top; // Установка указателя на следующий узел на текущий верхний узел
-        top = newNode; // Обновление верхнего элемента стека
-    }
 
-    // Функция для удаления элемента из стека
-    Binary pop() { 
-        if (isEmpty()) {  // Проверка, пуст ли стек
-            throw std::runtime_error("Stack is empty");  // Выброс исключения, если стек пуст
+        if (!socketPath.empty()) { // Режим сервера
+            if (big) runEvaluatorServer<BigBinary>(socketPath, memo); // Произвольная точность
+            else runEvaluatorServer<Binary32>(socketPath, memo); // 32 бита
+            return 0;
         }
-        Binary value = top->data; // Получение значения верхнего элемента
-        Node* temp = top; // Временное сохранение указателя на верхний элемент
-        top = top->next;  // Обновление верхнего элемента на следующий
-        delete temp;  // Освобождение памяти временного узла
-        return value; // Возвращение значения удаленного элемента
-    }
 
-    // Функция для проверки, пуст ли стек
-    bool isEmpty() const { 
-        return top == nullptr;  // Возврат true, если верхний элемент равен nullptr (стек пуст)
-    }
-};
+        if (forkjoin) { // Параллельное вычисление одного большого выражения
+            std::ios::sync_with_stdio(false); // Отключение синхронизации с stdio для быстрого чтения
+            if (big) runForkJoin<BigBinary>(inputFile); // Произвольная точность
+            else runForkJoin<Binary32>(inputFile); // 32 бита
+            return 0;
+        }
 
-// Функция для обработки постфиксного выражения
-Binary evaluatePostfix(const std::string& expression) {
-    std::istringstream iss(expression);  // Создание потока ввода из строки выражения
-    std::string token; // Переменная для хранения текущего токена
-    Stack stack; // Создание стека
+        if (stream) { // Потоковое вычисление одного большого выражения
+            std::ios::sync_with_stdio(false); // Отключение синхронизации с stdio для быстрого чтения
+            if (big) runStreaming<BigBinary>(inputFile, checkpoint); // Произвольная точность
+            else runStreaming<Binary32>(inputFile, checkpoint); // 32 бита
+            return 0;
+        }
 
-    while (iss >> token) {  // Цикл по каждому токену в выражении
-        if (token == "+" || token == "-" || token == "*") {  // Если токен оператор
-            if (stack.isEmpty()) throw std::runtime_error("Invalid expression"); // Проверка наличия операндов
-            Binary b = stack.pop();  // Извлечение второго операнда
+        if (!programFile.empty()) { // Перевод текста в двоичные программы (одна запись на строку)
+            std::ios::sync_with_stdio(false); // Отключение синхронизации с stdio для быстрого чтения
+            printBatchStats(std::cerr, writeProgramsInput(inputFile, programFile)); // Вывод объема перевода
+            return 0;
+        }
 
-            if (stack.isEmpty()) throw std::runtime_error("Invalid expression"); // Проверка наличия первого операнда
-            Binary a = stack.pop();  // Извлечение первого операнда
+        if (program) { // Вычисление программ прямо из отображенного файла без разбора текста
+            std::ios::sync_with_stdio(false); // Отключение синхронизации с stdio для быстрого вывода
+            BatchStats stats = big ? runProgramInput<BigBinary>(inputFile, std::cout, parallel, mode) // Произвольная точность
+                                   : runProgramInput<Binary32>(inputFile, std::cout, parallel, mode); // 32 бита
+            printBatchStats(std::cerr, stats); // Вывод пропускной способности
+            return 0;
+        }
 
-            if (token == "+") stack.push(a + b);  // Выполнение операции сложения и добавление результата в стек
-            else if (token == "-") stack.push(a - b); // Выполнение операции вычитания и добавление результата в стек
-            else if (token == "*") stack.push(a * b); // Выполнение операции умножения и добавление результата в стек
-            
-        } else {  // Если токен операнд
-            try { 
-                int value = std::stoi(token);  // Преобразование токена в целое число 
-                stack.push(Binary(value));// Добавление операнда в стек
-            } catch (...) { 
-                throw std::runtime_error("Invalid token: " + token); // Обработка ошибки по некорректному операнду
+        if (!formula.empty()) { // Формула компилируется один раз и вычисляется для каждой строки значений
+            std::ios::sync_with_stdio(false); // Отключение синхронизации с stdio для быстрого вывода
+            if (columnar && !big) { // Столбцовый режим: операции применяются к целым столбцам значений
+                BatchStats stats = runColumnarInput(inputFile, std::cout, CompiledExpression<Binary32>::compile(formula), mode);
+                printBatchStats(std::cerr, stats); // Вывод пропускной способности
+                return 0;
             }
+            if (bitsliced && !big) { // Битовые срезы: 64 строки значений за один проход по формуле
+                BatchStats stats = runBitSlicedInput(inputFile, std::cout, CompiledExpression<Binary32>::compile(formula), mode);
+                printBatchStats(std::cerr, stats); // Вывод пропускной способности
+                return 0;
+            }
+            if (jit && !big) { // Машинный код: ячейки стека в регистрах, переполнение по флагу процессора
+                BatchStats stats = runBatchInput(inputFile, std::cout, parallel, JitFormulaEvaluator<Binary32>(CompiledExpression<Binary32>::compile(formula)), mode);
+                printBatchStats(std::cerr, stats); // Вывод пропускной способности
+                return 0;
+            }
+            BatchStats stats = big
+                ? runBatchInput(inputFile, std::cout, parallel, FormulaEvaluator<BigBinary>(CompiledExpression<BigBinary>::compile(formula)), mode)
+                : runBatchInput(inputFile, std::cout, parallel, FormulaEvaluator<Binary32>(CompiledExpression<Binary32>::compile(formula)), mode);
+            printBatchStats(std::cerr, stats); // Вывод пропускной способности
+            return 0;
         }
-    }
-
-    if (stack.isEmpty()) throw std::runtime_error("Invalid expression"); // Проверка корректности выражения
-    
-    Binary result = stack.pop(); // Получение конечного результата
-    
-    if (!stack.isEmpty()) throw std::runtime_error("Invalid expression"); // Проверка корректности выражения
 
-    return result; // Возвращение итогового результата
-}
+        if (batch) { // Пакетный режим: выражения читаются построчно до конца входа
+            std::ios::sync_with_stdio(false); // Отключение синхронизации с stdio для быстрого вывода
+            if (infix) { // Инфиксные выражения вычисляются за один проход без перевода в постфиксную запись
+                BatchStats stats = big ? runBatchInput(inputFile, std::cout, parallel, evaluateInfix<BigBinary>, mode)
+                                       : runBatchInput(inputFile, std::cout, parallel, evaluateInfix<Binary32>, mode);
+                printBatchStats(std::cerr, stats); // Вывод пропускной способности
+                return 0;
+            }
+            if (memo) { // Вычисление с кэшем
+                if (big) runMemoizedBatch<BigBinary>(inputFile, parallel, mode);
+                else runMemoizedBatch<Binary32>(inputFile, parallel, mode);
+                return 0;
+            }
+            if (bitsliced && !big) { // Выражения одной формы собираются по 64 и вычисляются на битовых срезах
+                BatchStats stats = runBitSlicedBatchInput<Binary32>(inputFile, std::cout, evaluatePostfix<Binary32>, mode);
+                printBatchStats(std::cerr, stats); // Вывод пропускной способности
+                return 0;
+            }
+            if (pipelined) { // Конвейер: чтение, разбор на токены и вычисление в разных потоках
+                PipelineStats pipeline; // Загрузка и ожидание каждой стадии
+                BatchStats stats = big ? runPipelinedInput<BigBinary>(inputFile, std::cout, pipeline, mode)
+                                       : runPipelinedInput<Binary32>(inputFile, std::cout, pipeline, mode);
+                printBatchStats(std::cerr, stats); // Вывод пропускной способности
+                printPipelineStats(std::cerr, pipeline); // Вывод того, какая стадия самая медленная
+                return 0;
+            }
+            // Файл отображается в память и разбирается без копирования
+            BatchStats stats = big ? runBatchInput(inputFile, std::cout, parallel, tryEvaluatePostfix<BigBinary>, mode)
+                                   : runBatchInput(inputFile, std::cout, parallel, tryEvaluatePostfix<Binary32>, mode);
+            printBatchStats(std::cerr, stats); // Вывод пропускной способности
+            return 0;
+        }
 
-int main() {
-    
-    try {
-        
         std::string expression;
         
-        std::cout << "Enter a postfix expression: ";
+        std::cout << (infix ? "Enter an infix expression: " : "Enter a postfix expression: "); // Приглашение по виду записи
         
         std::getline(std::cin, expression);
 
         
-        Binary result = evaluatePostfix(expression);
-
-        
-        std::cout << "Result: " << result << std::endl;
+        if (big) {
+            BigBinary result = infix ? evaluateInfix<BigBinary>(expression) : evaluatePostfix<BigBinary>(expression); // Вычисление с произвольной точностью
+            std::cout << "Result: " << result << std::endl;
+        } else {
+            Binary32 result = infix ? evaluateInfix<Binary32>(expression) : evaluatePostfix<Binary32>(expression); // Вычисление в 32-битном числе
+            std::cout << "Result: " << result << std::endl;
+        }
 
         
     } catch (const std::exception& e) {
@@ -226,4 +304,5 @@ int main() {
 
     
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,287 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "evaluation.h"
+#include "format.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include "tokenizer.h"
+
+// Статистика пакетной обработки
+struct BatchStats {
+    size_t expressions = 0; // Количество обработанных выражений
+    size_t failed = 0; // Количество выражений с ошибкой
+    size_t tokens = 0; // Общее количество токенов
+    double seconds = 0; // Время обработки в секундах
+};
+
+// Подсчет токенов (слов, разделенных пробелами) в строке
+inline size_t countTokens(std::string_view line) {
+    size_t count = 0;
+    bool inToken = false;
+    for (char c : line) {
+        bool space = isSpace(c);
+        if (!space && !inToken) {
+            count++;
+        }
+        inToken = !space;
+    }
+    return count;
+}
+
+// Вычисление одной строки с выводом результата или ошибки на ее месте.
+// Вычислитель либо возвращает EvaluationResult (ошибка без исключения),
+// либо возвращает число и бросает исключение при ошибке.
+template <class Evaluate>
+void evaluateLine(std::string_view line, OutputBuffer& out, BatchStats& stats, Evaluate& evaluate) {
+    stats.expressions++;
+    stats.tokens += countTokens(line);
+    if constexpr (IsEvaluationResult<decltype(evaluate(line))>::value) {
+        auto result = evaluate(line);
+        if (result) {
+            out.appendResult(result.value());
+        } else {
+            stats.failed++;
+            out.appendError(result.error().message());
+        }
+    } else {
+        try {
+            out.appendResult(evaluate(line));
+        } catch (const std::exception& e) {
+            stats.failed++;
+            out.appendError(e.what());
+        }
+    }
+}
+
+// Вычисление всех строк текста (последняя строка может быть без '\n')
+template <class Evaluate>
+void evaluateLines(std::string_view text, OutputBuffer& out, BatchStats& stats, Evaluate& evaluate) {
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        evaluateLine(text.substr(0, end), out, stats, evaluate);
+        text.remove_prefix(end == text.size() ? end : end + 1);
+    }
+}
+
+// Пакетная обработка: каждая строка входа - отдельное постфиксное выражение.
+// Результат каждой строки выводится отдельной строкой в out, ошибка в строке
+// выводится на ее месте как "Error: ..." и не прерывает обработку.
+// Результаты копятся в OutputBuffer и пишутся в out большими блоками.
+template <class Evaluate>
+BatchStats runBatch(std::istream& in, std::ostream& out, Evaluate evaluate, FormatMode mode = FORMAT_BINARY) {
+    BatchStats stats;
+    std::string line;
+    auto start = std::chrono::steady_clock::now();
+
+    OutputBuffer buffer(out, mode);
+    while (std::getline(in, line)) {
+        evaluateLine(line, buffer, stats, evaluate);
+    }
+    buffer.flush();
+    out.flush();
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Пакетная обработка готового текста в памяти (например, отображенного файла).
+// Строки и токены берутся прямо из text без копирования.
+template <class Evaluate>
+BatchStats runBatch(std::string_view text, std::ostream& out, Evaluate evaluate, FormatMode mode = FORMAT_BINARY) {
+    BatchStats stats;
+    auto start = std::chrono::steady_clock::now();
+
+    OutputBuffer buffer(out, mode);
+    evaluateLines(text, buffer, stats, evaluate);
+    buffer.flush();
+    out.flush();
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Примерный объем одного куска входа для многопоточной обработки
+const size_t BATCH_CHUNK_BYTES = 64 * 1024;
+
+// Кусок входа: непрерывный текст из целых строк и результат его вычисления
+struct BatchChunk {
+    std::string storage; // Собственная копия текста (пусто, если текст в отображенном файле)
+    std::string_view text; // Строки куска
+    std::string output; // Результаты строк куска (текст OutputBuffer)
+    BatchStats stats; // Статистика куска
+    bool done = false; // Кусок вычислен
+};
+
+// Многопоточная обработка кусков с выводом результатов в порядке входа.
+// nextChunk(chunk) заполняет очередной кусок и возвращает false в конце входа,
+// evaluateChunk(text, buffer, stats) вычисляет текст куска.
+// Куски вычисляются в пуле с перехватом работы; в буфере переупорядочивания
+// одновременно находится не больше 4 кусков на поток, поэтому память ограничена.
+template <class EvaluateChunk, class NextChunk>
+BatchStats runChunked(NextChunk nextChunk, std::ostream& out, EvaluateChunk evaluateChunk, unsigned threads,
+                      FormatMode mode) {
+    BatchStats stats;
+    std::deque<std::shared_ptr<BatchChunk>> window; // Буфер переупорядочивания в порядке входа
+    std::mutex mutex;
+    std::condition_variable chunkDone;
+    // Пул объявлен последним: его потоки останавливаются раньше, чем
+    // разрушаются мьютекс и окно, которыми пользуются задачи
+    WorkStealingPool pool(threads);
+    const size_t maxInFlight = 4 * pool.size();
+    auto start = std::chrono::steady_clock::now();
+
+    // Вывод готовых кусков из начала окна; пока в окне больше limit кусков,
+    // ожидается готовность первого
+    auto drain = [&](size_t limit) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!window.empty()) {
+            if (!window.front()->done) {
+                if (window.size() <= limit) {
+                    break;
+                }
+                chunkDone.wait(lock, [&] { return window.front()->done; });
+            }
+            std::shared_ptr<BatchChunk> chunk = window.front();
+            window.pop_front();
+            lock.unlock();
+            out.write(chunk->output.data(), static_cast<std::streamsize>(chunk->output.size()));
+            stats.expressions += chunk->stats.expressions;
+            stats.failed += chunk->stats.failed;
+            stats.tokens += chunk->stats.tokens;
+            lock.lock();
+        }
+    };
+
+    while (true) {
+        std::shared_ptr<BatchChunk> chunk = std::make_shared<BatchChunk>();
+        if (!nextChunk(*chunk)) {
+            break;
+        }
+        drain(maxInFlight - 1);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            window.push_back(chunk);
+        }
+        pool.submit([chunk, &evaluateChunk, &mutex, &chunkDone, mode] {
+            OutputBuffer result(mode);
+            BatchStats chunkStats;
+            evaluateChunk(chunk->text, result, chunkStats);
+            chunk->storage.clear();
+            chunk->storage.shrink_to_fit();
+            std::lock_guard<std::mutex> lock(mutex);
+            chunk->output.swap(result.str());
+            chunk->stats = chunkStats;
+            chunk->done = true;
+            chunkDone.notify_all();
+        });
+    }
+    drain(0);
+    out.flush();
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Многопоточная пакетная обработка: куски - целые строки выражений
+template <class Evaluate, class NextChunk>
+BatchStats runChunkedBatch(NextChunk nextChunk, std::ostream& out, Evaluate evaluate, unsigned threads, FormatMode mode) {
+    auto evaluateChunk = [&evaluate](std::string_view text, OutputBuffer& buffer, BatchStats& stats) {
+        evaluateLines(text, buffer, stats, evaluate);
+    };
+    return runChunked(nextChunk, out, evaluateChunk, threads, mode);
+}
+
+// Многопоточная обработка потока: строки копируются в куски объемом около
+// BATCH_CHUNK_BYTES. Очень длинное выражение попадает в отдельный кусок
+// и не задерживает соседние строки.
+template <class Evaluate>
+BatchStats runParallelBatch(std::istream& in, std::ostream& out, Evaluate evaluate, unsigned threads = 0,
+                            FormatMode mode = FORMAT_BINARY) {
+    std::string pending; // Длинная строка, отложенная до следующего куска
+    bool hasPending = false;
+    auto nextChunk = [&](BatchChunk& chunk) {
+        std::string line;
+        if (hasPending) {
+            chunk.storage = std::move(pending);
+            chunk.storage += '\n';
+            hasPending = false;
+        }
+        while (chunk.storage.size() < BATCH_CHUNK_BYTES && std::getline(in, line)) {
+            if (line.size() >= BATCH_CHUNK_BYTES && !chunk.storage.empty()) {
+                pending = std::move(line);
+                hasPending = true;
+                break;
+            }
+            chunk.storage += line;
+            chunk.storage += '\n';
+        }
+        chunk.text = chunk.storage;
+        return !chunk.storage.empty();
+    };
+    return runChunkedBatch(nextChunk, out, evaluate, threads, mode);
+}
+
+// Многопоточная обработка текста в памяти: куски - это участки text,
+// строки не копируются. Длинная строка также выделяется в отдельный кусок.
+template <class Evaluate>
+BatchStats runParallelBatch(std::string_view text, std::ostream& out, Evaluate evaluate, unsigned threads = 0,
+                            FormatMode mode = FORMAT_BINARY) {
+    auto nextChunk = [&](BatchChunk& chunk) {
+        if (text.empty()) {
+            return false;
+        }
+        size_t firstEnd = text.find('\n');
+        size_t end;
+        if (firstEnd == std::string_view::npos || firstEnd >= BATCH_CHUNK_BYTES) {
+            // Первая же строка длинная - кусок из нее одной
+            end = firstEnd == std::string_view::npos ? text.size() : firstEnd + 1;
+        } else if (text.size() <= BATCH_CHUNK_BYTES) {
+            end = text.size();
+        } else {
+            // Граница куска - последний перевод строки в пределах объема куска
+            end = text.rfind('\n', BATCH_CHUNK_BYTES - 1) + 1;
+        }
+        chunk.text = text.substr(0, end);
+        text.remove_prefix(end);
+        return true;
+    };
+    return runChunkedBatch(nextChunk, out, evaluate, threads, mode);
+}
+
+// Пакетный режим программы: выражения берутся из файла (он отображается
+// в память) или, если имя файла пустое, из стандартного ввода
+template <class Evaluate>
+BatchStats runBatchInput(const std::string& inputFile, std::ostream& out, bool parallel, Evaluate evaluate,
+                         FormatMode mode = FORMAT_BINARY) {
+    if (!inputFile.empty()) {
+        MappedFile mapped(inputFile);
+        return parallel ? runParallelBatch(mapped.view(), out, evaluate, 0, mode) : runBatch(mapped.view(), out, evaluate, mode);
+    }
+    return parallel ? runParallelBatch(std::cin, out, evaluate, 0, mode) : runBatch(std::cin, out, evaluate, mode);
+}
+
+// Вывод итоговой статистики пакетной обработки
+inline void printBatchStats(std::ostream& os, const BatchStats& stats) {
+    double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+    os << "Processed " << stats.expressions << " expressions (" << stats.failed << " failed), "
+       << stats.tokens << " tokens in " << stats.seconds << " s: "
+       << stats.expressions / seconds << " expressions/s, "
+       << stats.tokens / seconds << " tokens/s" << std::endl;
+}
+
+#endif
@@ -0,0 +1,160 @@
+// Замер производительности всех вычислителей на одних и тех же выражениях.
+// Программы 1.cpp и 2.cpp подключаются как библиотеки (без своих main).
+// Сборка: g++ -O2 -std=c++17 -pthread bench.cpp -o bench
+// Запуск: bench [--engine имя]... [--tokens N] [--depth D] [--count C]
+//               [--mix сложение:вычитание:умножение] [--values V] [--seed S]
+#define POSTFIX_NO_MAIN
+#include "1.cpp"
+#include "2.cpp"
+#undef POSTFIX_NO_MAIN
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "generator.h"
+
+// Вычислитель для замера: результат сворачивается в число, чтобы
+// компилятор не мог выбросить вычисление
+struct Engine {
+    const char* name; // Имя для --engine
+    const char* description; // Описание
+    std::function<uint64_t(std::string_view)> evaluate; // Вычисление одного выражения
+};
+
+// Все вычислители
+std::vector<Engine> allEngines() {
+    std::vector<Engine> engines;
+    engines.push_back({"int", "1.cpp: стек int", [](std::string_view e) {
+        return static_cast<uint64_t>(evaluatePostfix(e));
+    }});
+    engines.push_back({"binary8", "2.cpp: Binary<8, OVERFLOW_THROW>", [](std::string_view e) {
+        return static_cast<uint64_t>(evaluatePostfix<Binary<8, OVERFLOW_THROW>>(e).word());
+    }});
+    engines.push_back({"saturate8", "2.cpp: Binary<8, OVERFLOW_SATURATE>", [](std::string_view e) {
+        return static_cast<uint64_t>(evaluatePostfix<Binary<8, OVERFLOW_SATURATE>>(e).word());
+    }});
+    engines.push_back({"flag32", "2.cpp: Binary<32, OVERFLOW_FLAG>", [](std::string_view e) {
+        Binary<32, OVERFLOW_FLAG> result = evaluatePostfix<Binary<32, OVERFLOW_FLAG>>(e);
+        return static_cast<uint64_t>(result.word()) + result.overflowed();
+    }});
+    engines.push_back({"binary32", "2.cpp: Binary32", [](std::string_view e) {
+        return static_cast<uint64_t>(evaluatePostfix<Binary32>(e).word());
+    }});
+    engines.push_back({"big", "2.cpp: BigBinary", [](std::string_view e) {
+        return static_cast<uint64_t>(evaluatePostfix<BigBinary>(e).size());
+    }});
+    engines.push_back({"bytecode", "bytecode.h: компиляция и вычисление, Binary32", [](std::string_view e) {
+        return static_cast<uint64_t>(CompiledExpression<Binary32>::compile(e).evaluate(nullptr).word());
+    }});
+    engines.push_back({"memo", "memo.h: кэш выражений и подвыражений, Binary32", [](std::string_view e) {
+        static PostfixMemo<Binary32> memo(MEMO_DEFAULT_CAPACITY);
+        return static_cast<uint64_t>(memo.evaluate(e).word());
+    }});
+    return engines;
+}
+
+// Результат замера одного вычислителя
+struct BenchResult {
+    size_t expressions = 0; // Вычислено выражений
+    size_t failed = 0; // Из них с ошибкой (например, переполнение)
+    size_t tokens = 0; // Всего токенов
+    double seconds = 0; // Общее время
+    double p50 = 0, p99 = 0, p999 = 0; // Задержка одного выражения, мкс
+    uint64_t checksum = 0; // Свертка результатов
+};
+
+BenchResult runEngine(const Engine& engine, const std::vector<std::string>& expressions) {
+    BenchResult result;
+    std::vector<double> latencies;
+    latencies.reserve(expressions.size());
+
+    for (const std::string& expression : expressions) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            result.checksum += engine.evaluate(expression);
+        } catch (const std::exception&) {
+            result.failed++;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.seconds += seconds;
+        latencies.push_back(seconds * 1e6);
+        result.expressions++;
+        result.tokens += countTokens(expression);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    result.p50 = percentile(latencies, 0.50);
+    result.p99 = percentile(latencies, 0.99);
+    result.p999 = percentile(latencies, 0.999);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        GeneratorOptions options;
+        size_t count = 0; // 0 - около миллиона токенов на вычислитель
+        std::vector<std::string> selected;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--engine" && hasValue) selected.push_back(argv[++i]);
+            else if (arg == "--tokens" && hasValue) options.tokens = std::stoull(argv[++i]);
+            else if (arg == "--depth" && hasValue) options.maxDepth = std::stoull(argv[++i]);
+            else if (arg == "--count" && hasValue) count = std::stoull(argv[++i]);
+            else if (arg == "--values" && hasValue) options.maxValue = std::stoi(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+            else if (arg == "--mix" && hasValue) {
+                // Частоты операций в виде "1:1:1" (сложение, вычитание, умножение)
+                std::string mix = argv[++i];
+                size_t first = mix.find(':');
+                size_t second = first == std::string::npos ? std::string::npos : mix.find(':', first + 1);
+                if (second == std::string::npos) throw std::runtime_error("Invalid mix: " + mix);
+                options.addWeight = static_cast<unsigned>(std::stoul(mix.substr(0, first)));
+                options.subWeight = static_cast<unsigned>(std::stoul(mix.substr(first + 1, second - first - 1)));
+                options.mulWeight = static_cast<unsigned>(std::stoul(mix.substr(second + 1)));
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+        if (count == 0) {
+            count = std::max<size_t>(1, 1000000 / std::max<size_t>(1, options.tokens));
+        }
+
+        // Выражения генерируются заранее, чтобы не входить в замер
+        std::vector<std::string> expressions(count);
+        ExpressionGenerator generator(options);
+        for (std::string& expression : expressions) {
+            generator.generate(expression);
+        }
+
+        std::cout << std::left << std::setw(10) << "engine" << std::right
+                  << std::setw(10) << "exprs" << std::setw(9) << "failed"
+                  << std::setw(12) << "Mtokens/s" << std::setw(12) << "exprs/s"
+                  << std::setw(11) << "p50 us" << std::setw(11) << "p99 us" << std::setw(11) << "p999 us" << '\n';
+        for (const Engine& engine : allEngines()) {
+            if (!selected.empty() && std::find(selected.begin(), selected.end(), engine.name) == selected.end()) {
+                continue;
+            }
+            BenchResult result = runEngine(engine, expressions);
+            double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+            std::cout << std::left << std::setw(10) << engine.name << std::right << std::fixed
+                      << std::setw(10) << result.expressions << std::setw(9) << result.failed
+                      << std::setprecision(2) << std::setw(12) << result.tokens / seconds / 1e6
+                      << std::setprecision(0) << std::setw(12) << result.expressions / seconds
+                      << std::setprecision(2) << std::setw(11) << result.p50
+                      << std::setw(11) << result.p99 << std::setw(11) << result.p999
+                      << "  (" << engine.description << ", checksum " << result.checksum << ")" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,606 @@
+#ifndef BIGBINARY_H
+#define BIGBINARY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Класс для представления бинарного числа произвольной точности.
+// Модуль хранится массивом 32-битных слов (limb), младшее слово первое,
+// знак хранится отдельно. Ноль всегда неотрицательный и не имеет слов.
+class BigBinary {
+public:
+    typedef uint32_t Limb;
+    typedef uint64_t DoubleLimb;
+
+    // Размер одного слова в битах
+    static const int LIMB_BITS = 32;
+    // Начиная с этого числа слов умножение выполняется по Карацубе (подобрано замером)
+    static const size_t KARATSUBA_THRESHOLD = 40;
+    // Наибольшая длина результата сдвига влево в битах: десятичный вывод
+    // числа занимает время, квадратичное по длине, и одна строка вида
+    // "1 300 300 * 300 * <<" иначе занимала бы вычислитель на минуты
+    static const uint64_t MAX_SHIFT_BITS = 1 << 16;
+
+private:
+    std::vector<Limb> limbs; // Слова модуля числа
+    bool negative; // Знак числа
+
+    // Удаление старших нулевых слов
+    void trim() {
+        while (!limbs.empty() && limbs.back() == 0) {
+            limbs.pop_back();
+        }
+        if (limbs.empty()) {
+            negative = false;
+        }
+    }
+
+    // Длина числа без старших нулевых слов
+    static size_t significant(const Limb* a, size_t n) {
+        while (n > 0 && a[n - 1] == 0) {
+            n--;
+        }
+        return n;
+    }
+
+    // Сравнение модулей: -1, 0 или 1
+    static int compare(const std::vector<Limb>& a, const std::vector<Limb>& b) {
+        if (a.size() != b.size()) {
+            return a.size() < b.size() ? -1 : 1;
+        }
+        for (size_t i = a.size(); i-- > 0;) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // Прибавление src к dst на месте с распространением переноса.
+    // Вызывающий гарантирует, что результат помещается в dst.
+    static void addInPlace(Limb* dst, size_t dstLen, const Limb* src, size_t srcLen) {
+        DoubleLimb carry = 0;
+        size_t i = 0;
+        for (; i < srcLen; i++) {
+            DoubleLimb sum = DoubleLimb(dst[i]) + src[i] + carry;
+            dst[i] = static_cast<Limb>(sum);
+            carry = sum >> LIMB_BITS;
+        }
+        for (; carry != 0 && i < dstLen; i++) {
+            DoubleLimb sum = DoubleLimb(dst[i]) + carry;
+            dst[i] = static_cast<Limb>(sum);
+            carry = sum >> LIMB_BITS;
+        }
+    }
+
+    // Вычитание src из dst на месте с распространением заема.
+    // Вызывающий гарантирует, что dst >= src.
+    static void subInPlace(Limb* dst, size_t dstLen, const Limb* src, size_t srcLen) {
+        Limb borrow = 0;
+        size_t i = 0;
+        for (; i < srcLen; i++) {
+            DoubleLimb diff = DoubleLimb(dst[i]) - src[i] - borrow;
+            dst[i] = static_cast<Limb>(diff);
+            borrow = (diff >> LIMB_BITS) != 0;
+        }
+        for (; borrow != 0 && i < dstLen; i++) {
+            borrow = dst[i] == 0;
+            dst[i]--;
+        }
+    }
+
+    // Умножение столбиком: out (длины na + nb, обнулен) = a * b
+    static void mulSchool(const Limb* a, size_t na, const Limb* b, size_t nb, Limb* out) {
+        for (size_t i = 0; i < na; i++) {
+            DoubleLimb carry = 0;
+            for (size_t j = 0; j < nb; j++) {
+                DoubleLimb cur = DoubleLimb(a[i]) * b[j] + out[i + j] + carry;
+                out[i + j] = static_cast<Limb>(cur);
+                carry = cur >> LIMB_BITS;
+            }
+            out[i + nb] = static_cast<Limb>(carry);
+        }
+    }
+
+    // Умножение по Карацубе: out (длины na + nb, обнулен) = a * b
+    static void mulKaratsuba(const Limb* a, size_t na, const Limb* b, size_t nb, Limb* out) {
+        na = significant(a, na);
+        nb = significant(b, nb);
+        if (na < nb) {
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+        if (nb < KARATSUBA_THRESHOLD) {
+            mulSchool(a, na, b, nb, out);
+            return;
+        }
+
+        // Сильно несбалансированные операнды: a режется на куски длины nb
+        if (2 * nb <= na) {
+            std::vector<Limb> part(2 * nb);
+            for (size_t offset = 0; offset < na; offset += nb) {
+                size_t len = std::min(nb, na - offset);
+                std::fill(part.begin(), part.end(), 0);
+                mulKaratsuba(a + offset, len, b, nb, part.data());
+                addInPlace(out + offset, na + nb - offset, part.data(), len + nb);
+            }
+            return;
+        }
+
+        // a = a1 * B^m + a0, b = b1 * B^m + b0
+        size_t m = na / 2;
+        const Limb* a0 = a;
+        const Limb* a1 = a + m;
+        const Limb* b0 = b;
+        const Limb* b1 = b + m;
+        size_t na0 = significant(a0, m);
+        size_t nb0 = significant(b0, m);
+        size_t na1 = na - m;
+        size_t nb1 = nb - m;
+
+        // z0 = a0 * b0 и z2 = a1 * b1 пишутся сразу на свои места в out
+        mulKaratsuba(a0, na0, b0, nb0, out);
+        mulKaratsuba(a1, na1, b1, nb1, out + 2 * m);
+
+        // z1 = (a0 + a1) * (b0 + b1) - z0 - z2
+        std::vector<Limb> sa(std::max(na0, na1) + 1, 0);
+        std::copy(a1, a1 + na1, sa.begin());
+        addInPlace(sa.data(), sa.size(), a0, na0);
+        std::vector<Limb> sb(std::max(nb0, nb1) + 1, 0);
+        std::copy(b1, b1 + nb1, sb.begin());
+        addInPlace(sb.data(), sb.size(), b0, nb0);
+        size_t nsa = significant(sa.data(), sa.size());
+        size_t nsb = significant(sb.data(), sb.size());
+
+        std::vector<Limb> z1(nsa + nsb + 1, 0);
+        mulKaratsuba(sa.data(), nsa, sb.data(), nsb, z1.data());
+        subInPlace(z1.data(), z1.size(), out, na0 + nb0);
+        subInPlace(z1.data(), z1.size(), out + 2 * m, na1 + nb1);
+
+        addInPlace(out + m, na + nb - m, z1.data(), significant(z1.data(), z1.size()));
+    }
+
+    // Деление модуля на малое число на месте, возвращает остаток
+    static Limb divSmall(std::vector<Limb>& a, Limb divisor) {
+        DoubleLimb rem = 0;
+        for (size_t i = a.size(); i-- > 0;) {
+            DoubleLimb cur = (rem << LIMB_BITS) | a[i];
+            a[i] = static_cast<Limb>(cur / divisor);
+            rem = cur % divisor;
+        }
+        while (!a.empty() && a.back() == 0) {
+            a.pop_back();
+        }
+        return static_cast<Limb>(rem);
+    }
+
+    // Деление модулей по словам (алгоритм D Кнута): quotient = a / b,
+    // remainder = a % b (b не ноль). Делитель нормализуется сдвигом, чтобы
+    // старший бит его старшего слова был единицей; тогда оценка цифры частного
+    // по двум старшим словам остатка и старшему слову делителя (деление 64/32)
+    // после уточнения по второму слову делителя больше верной не более чем на 1.
+    // Делитель из одного слова - быстрый путь
+    static void divideMagnitudes(const std::vector<Limb>& a, const std::vector<Limb>& b,
+                                 std::vector<Limb>& quotient, std::vector<Limb>& remainder) {
+        if (b.size() == 1) {
+            quotient = a;
+            Limb rest = divSmall(quotient, b[0]);
+            remainder.clear();
+            if (rest != 0) {
+                remainder.push_back(rest);
+            }
+            return;
+        }
+        if (a.size() < b.size()) {
+            quotient.clear();
+            remainder = a;
+            return;
+        }
+        const size_t n = b.size();
+        const size_t m = a.size() - n;
+        const DoubleLimb BASE = DoubleLimb(1) << LIMB_BITS;
+        int shift = 0;
+        while ((b.back() << shift & (Limb(1) << (LIMB_BITS - 1))) == 0) {
+            shift++;
+        }
+        std::vector<Limb> v = shiftLeftMagnitude(b, shift);
+        std::vector<Limb> u = shiftLeftMagnitude(a, shift);
+        u.resize(a.size() + 1, 0);
+        quotient.assign(m + 1, 0);
+        for (size_t j = m + 1; j-- > 0;) {
+            // Оценка цифры частного
+            DoubleLimb numerator = (DoubleLimb(u[j + n]) << LIMB_BITS) | u[j + n - 1];
+            DoubleLimb digit = numerator / v[n - 1];
+            DoubleLimb rest = numerator % v[n - 1];
+            while (digit >= BASE || digit * v[n - 2] > ((rest << LIMB_BITS) | u[j + n - 2])) {
+                digit--;
+                rest += v[n - 1];
+                if (rest >= BASE) {
+                    break;
+                }
+            }
+            // Вычитание digit * v из u[j..j+n]
+            int64_t borrow = 0;
+            for (size_t i = 0; i < n; i++) {
+                DoubleLimb product = digit * v[i];
+                int64_t t = static_cast<int64_t>(u[i + j]) - borrow - static_cast<int64_t>(product & (BASE - 1));
+                u[i + j] = static_cast<Limb>(t);
+                borrow = static_cast<int64_t>(product >> LIMB_BITS) - (t >> LIMB_BITS);
+            }
+            int64_t top = static_cast<int64_t>(u[j + n]) - borrow;
+            u[j + n] = static_cast<Limb>(top);
+            if (top < 0) {
+                // Оценка оказалась на 1 больше: делитель прибавляется обратно
+                digit--;
+                DoubleLimb carry = 0;
+                for (size_t i = 0; i < n; i++) {
+                    DoubleLimb sum = DoubleLimb(u[i + j]) + v[i] + carry;
+                    u[i + j] = static_cast<Limb>(sum);
+                    carry = sum >> LIMB_BITS;
+                }
+                u[j + n] = static_cast<Limb>(u[j + n] + carry);
+            }
+            quotient[j] = static_cast<Limb>(digit);
+        }
+        while (!quotient.empty() && quotient.back() == 0) {
+            quotient.pop_back();
+        }
+        u.resize(n);
+        remainder = shiftRightMagnitude(u, shift);
+    }
+
+    // Сдвиг модуля влево на shift битов
+    static std::vector<Limb> shiftLeftMagnitude(const std::vector<Limb>& a, uint64_t shift) {
+        if (a.empty()) {
+            return a;
+        }
+        size_t words = static_cast<size_t>(shift / LIMB_BITS);
+        int bits = static_cast<int>(shift % LIMB_BITS);
+        std::vector<Limb> result(words, 0);
+        Limb carry = 0;
+        for (Limb limb : a) {
+            result.push_back(static_cast<Limb>(limb << bits) | carry);
+            carry = bits ? limb >> (LIMB_BITS - bits) : 0;
+        }
+        if (carry != 0) {
+            result.push_back(carry);
+        }
+        return result;
+    }
+
+    // Сдвиг модуля вправо на shift битов (младшие биты отбрасываются)
+    static std::vector<Limb> shiftRightMagnitude(const std::vector<Limb>& a, uint64_t shift) {
+        size_t words = static_cast<size_t>(std::min<uint64_t>(shift / LIMB_BITS, a.size()));
+        int bits = static_cast<int>(shift % LIMB_BITS);
+        std::vector<Limb> result(a.begin() + static_cast<std::ptrdiff_t>(words), a.end());
+        for (size_t i = 0; i < result.size(); i++) {
+            Limb high = i + 1 < result.size() && bits ? result[i + 1] << (LIMB_BITS - bits) : 0;
+            result[i] = (result[i] >> bits) | high;
+        }
+        while (!result.empty() && result.back() == 0) {
+            result.pop_back();
+        }
+        return result;
+    }
+
+    // Были ли отброшены ненулевые биты при сдвиге модуля вправо
+    static bool lostBits(const std::vector<Limb>& a, uint64_t shift) {
+        for (size_t i = 0; i < a.size(); i++) {
+            uint64_t low = uint64_t(i) * LIMB_BITS;
+            if (low >= shift) {
+                break;
+            }
+            uint64_t count = shift - low;
+            Limb mask = count >= LIMB_BITS ? ~Limb(0) : (Limb(1) << count) - 1;
+            if (a[i] & mask) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Величина сдвига: неотрицательное число, помещающееся в 32 бита
+    static uint64_t shiftCount(const BigBinary& count) {
+        if (count.negative) {
+            throw std::runtime_error("Invalid shift");
+        }
+        if (count.limbs.size() > 1) {
+            throw std::runtime_error("Shift is too large");
+        }
+        return count.limbs.empty() ? 0 : count.limbs[0];
+    }
+
+    // Дополнительный код числа в width словах (width больше длины модуля)
+    std::vector<Limb> twosComplement(size_t width) const {
+        std::vector<Limb> result(limbs);
+        result.resize(width, 0);
+        if (negative) {
+            DoubleLimb carry = 1;
+            for (Limb& limb : result) {
+                DoubleLimb sum = DoubleLimb(static_cast<Limb>(~limb)) + carry;
+                limb = static_cast<Limb>(sum);
+                carry = sum >> LIMB_BITS;
+            }
+        }
+        return result;
+    }
+
+    // Число по дополнительному коду (знак - старший бит)
+    static BigBinary fromTwosComplement(std::vector<Limb> code) {
+        BigBinary result;
+        result.negative = !code.empty() && (code.back() >> (LIMB_BITS - 1)) != 0;
+        if (result.negative) {
+            DoubleLimb carry = 1;
+            for (Limb& limb : code) {
+                DoubleLimb sum = DoubleLimb(static_cast<Limb>(~limb)) + carry;
+                limb = static_cast<Limb>(sum);
+                carry = sum >> LIMB_BITS;
+            }
+        }
+        result.limbs = std::move(code);
+        result.trim();
+        return result;
+    }
+
+    // Побитовая операция над дополнительными кодами бесконечной длины
+    template <class Operation>
+    BigBinary bitwise(const BigBinary& other, Operation operation) const {
+        size_t width = std::max(limbs.size(), other.limbs.size()) + 1;
+        std::vector<Limb> a = twosComplement(width);
+        std::vector<Limb> b = other.twosComplement(width);
+        for (size_t i = 0; i < width; i++) {
+            a[i] = operation(a[i], b[i]);
+        }
+        return fromTwosComplement(std::move(a));
+    }
+
+public:
+    // Конструктор по умолчанию
+    BigBinary() : negative(false) {}
+
+    // Конструктор с параметром - десятичное число
+    BigBinary(long long _decimal) : negative(_decimal < 0) {
+        uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(_decimal) : static_cast<uint64_t>(_decimal);
+        while (magnitude != 0) {
+            limbs.push_back(static_cast<Limb>(magnitude));
+            magnitude >>= LIMB_BITS;
+        }
+    }
+
+    // Количество слов в модуле числа
+    size_t size() const {
+        return limbs.size();
+    }
+
+    // Количество значащих битов модуля
+    uint64_t bitLength() const {
+        if (limbs.empty()) {
+            return 0;
+        }
+        uint64_t bits = uint64_t(limbs.size() - 1) * LIMB_BITS;
+        for (Limb top = limbs.back(); top != 0; top >>= 1) {
+            bits++;
+        }
+        return bits;
+    }
+
+    // Длиннее ли MAX_SHIFT_BITS результат сдвига влево на count
+    // (count - неотрицательное число из одного слова)
+    bool shiftTooLarge(const BigBinary& count) const {
+        return !limbs.empty() && !count.limbs.empty() && bitLength() + count.limbs[0] > MAX_SHIFT_BITS;
+    }
+
+    // Проверка знака
+    bool isNegative() const {
+        return negative;
+    }
+
+    // Десятичное представление числа
+    std::string decimal() const {
+        if (limbs.empty()) {
+            return "0";
+        }
+        std::vector<Limb> magnitude(limbs);
+        std::string text;
+        while (!magnitude.empty()) {
+            Limb chunk = divSmall(magnitude, 1000000000);
+            for (int i = 0; i < 9 && (chunk != 0 || !magnitude.empty()); i++) {
+                text += static_cast<char>('0' + chunk % 10);
+                chunk /= 10;
+            }
+        }
+        if (negative) {
+            text += '-';
+        }
+        std::reverse(text.begin(), text.end());
+        return text;
+    }
+
+    // Шестнадцатеричное представление: знак и модуль ("-0x1f")
+    std::string hex() const {
+        static const char DIGITS[] = "0123456789abcdef";
+        std::string text = negative ? "-0x" : "0x";
+        if (limbs.empty()) {
+            return text + '0';
+        }
+        bool leading = true;
+        for (size_t i = limbs.size(); i-- > 0;) {
+            for (int shift = LIMB_BITS - 4; shift >= 0; shift -= 4) {
+                Limb digit = (limbs[i] >> shift) & 0xf;
+                if (leading && digit == 0) {
+                    continue;
+                }
+                leading = false;
+                text += DIGITS[digit];
+            }
+        }
+        return text;
+    }
+
+    // Оператор вывода в поток: знак и биты модуля, затем десятичное число
+    friend std::ostream& operator<<(std::ostream& os, const BigBinary& b) {
+        std::string text;
+        if (b.negative) {
+            text += '-';
+        }
+        if (b.limbs.empty()) {
+            text += '0';
+        }
+        for (size_t i = b.limbs.size(); i-- > 0;) {
+            int bit = LIMB_BITS - 1;
+            if (i == b.limbs.size() - 1) {
+                while (bit > 0 && ((b.limbs[i] >> bit) & 1) == 0) {
+                    bit--;
+                }
+            }
+            for (; bit >= 0; bit--) {
+                text += static_cast<char>('0' + ((b.limbs[i] >> bit) & 1));
+            }
+        }
+        os << text << " (" << b.decimal() << ")";
+        return os;
+    }
+
+    // Оператор сложения
+    BigBinary operator+(const BigBinary& other) const {
+        BigBinary result;
+        if (negative == other.negative) {
+            const BigBinary& longer = limbs.size() >= other.limbs.size() ? *this : other;
+            const BigBinary& shorter = limbs.size() >= other.limbs.size() ? other : *this;
+            result.limbs = longer.limbs;
+            result.limbs.push_back(0);
+            addInPlace(result.limbs.data(), result.limbs.size(), shorter.limbs.data(), shorter.limbs.size());
+            result.negative = negative;
+        } else {
+            bool thisLarger = compare(limbs, other.limbs) >= 0;
+            const BigBinary& larger = thisLarger ? *this : other;
+            const BigBinary& smaller = thisLarger ? other : *this;
+            result.limbs = larger.limbs;
+            subInPlace(result.limbs.data(), result.limbs.size(), smaller.limbs.data(), smaller.limbs.size());
+            result.negative = larger.negative;
+        }
+        result.trim();
+        return result;
+    }
+
+    // Унарный оператор минус
+    BigBinary operator-() const {
+        BigBinary result(*this);
+        result.negative = !negative && !limbs.empty();
+        return result;
+    }
+
+    // Оператор вычитания
+    BigBinary operator-(const BigBinary& other) const {
+        return *this + (-other);
+    }
+
+    // Оператор умножения
+    BigBinary operator*(const BigBinary& other) const {
+        BigBinary result;
+        if (limbs.empty() || other.limbs.empty()) {
+            return result;
+        }
+        result.limbs.assign(limbs.size() + other.limbs.size(), 0);
+        mulKaratsuba(limbs.data(), limbs.size(), other.limbs.data(), other.limbs.size(), result.limbs.data());
+        result.negative = negative != other.negative;
+        result.trim();
+        return result;
+    }
+
+    // Оператор деления (с отбрасыванием дробной части, как в C++)
+    BigBinary operator/(const BigBinary& other) const {
+        if (other.limbs.empty()) {
+            throw std::runtime_error("Division by zero");
+        }
+        BigBinary result;
+        std::vector<Limb> remainder;
+        divideMagnitudes(limbs, other.limbs, result.limbs, remainder);
+        result.negative = negative != other.negative;
+        result.trim();
+        return result;
+    }
+
+    // Оператор остатка от деления (знак как у делимого)
+    BigBinary operator%(const BigBinary& other) const {
+        if (other.limbs.empty()) {
+            throw std::runtime_error("Division by zero");
+        }
+        BigBinary result;
+        std::vector<Limb> quotient;
+        divideMagnitudes(limbs, other.limbs, quotient, result.limbs);
+        result.negative = negative;
+        result.trim();
+        return result;
+    }
+
+    // Сдвиг влево (умножение на 2^count)
+    BigBinary operator<<(const BigBinary& count) const {
+        uint64_t shift = shiftCount(count);
+        if (shiftTooLarge(count)) {
+            throw std::runtime_error("Shift is too large");
+        }
+        BigBinary result;
+        result.limbs = shiftLeftMagnitude(limbs, shift);
+        result.negative = negative;
+        result.trim();
+        return result;
+    }
+
+    // Арифметический сдвиг вправо (деление на 2^count с округлением вниз,
+    // как у дополнительного кода бесконечной длины)
+    BigBinary operator>>(const BigBinary& count) const {
+        uint64_t shift = shiftCount(count);
+        BigBinary result;
+        result.limbs = shiftRightMagnitude(limbs, shift);
+        result.negative = negative;
+        result.trim();
+        if (negative && lostBits(limbs, shift)) {
+            result = result - BigBinary(1);
+        }
+        return result;
+    }
+
+    // Логический сдвиг вправо определен только для неотрицательных чисел:
+    // у дополнительного кода бесконечной длины нет старшего бита
+    BigBinary logicalShiftRight(const BigBinary& count) const {
+        if (negative) {
+            throw std::runtime_error("Logical shift of a negative number");
+        }
+        return *this >> count;
+    }
+
+    // Побитовые операции над дополнительным кодом бесконечной длины
+    BigBinary operator&(const BigBinary& other) const {
+        return bitwise(other, [](Limb a, Limb b) { return static_cast<Limb>(a & b); });
+    }
+
+    BigBinary operator|(const BigBinary& other) const {
+        return bitwise(other, [](Limb a, Limb b) { return static_cast<Limb>(a | b); });
+    }
+
+    BigBinary operator^(const BigBinary& other) const {
+        return bitwise(other, [](Limb a, Limb b) { return static_cast<Limb>(a ^ b); });
+    }
+
+    // Инвертирование всех битов: ~a = -a - 1
+    BigBinary operator~() const {
+        return -*this - BigBinary(1);
+    }
+
+    // Операторы сравнения
+    bool operator==(const BigBinary& other) const {
+        return negative == other.negative && limbs == other.limbs;
+    }
+
+    bool operator!=(const BigBinary& other) const {
+        return !(*this == other);
+    }
+};
+
+#endif
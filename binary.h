@@ -0,0 +1,371 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include "instrument.h"
+
+// Машинное слово для хранения бинарного числа заданной разрядности.
+// Wide - знаковый тип хотя бы на бит шире слова (частичный остаток деления)
+template <int N> struct BinaryStorage;
+
+template <> struct BinaryStorage<8> {
+    typedef uint8_t Word;
+    typedef int8_t Signed;
+    typedef int16_t Wide;
+};
+
+template <> struct BinaryStorage<16> {
+    typedef uint16_t Word;
+    typedef int16_t Signed;
+    typedef int32_t Wide;
+};
+
+template <> struct BinaryStorage<32> {
+    typedef uint32_t Word;
+    typedef int32_t Signed;
+    typedef int64_t Wide;
+};
+
+template <> struct BinaryStorage<64> {
+    typedef uint64_t Word;
+    typedef int64_t Signed;
+    typedef __int128 Wide;
+};
+
+// Политика обработки переполнения при арифметике
+enum OverflowPolicy {
+    OVERFLOW_WRAP, // Результат по модулю 2^N, без проверок (самый быстрый режим)
+    OVERFLOW_THROW, // Исключение "Overflow..."
+    OVERFLOW_SATURATE, // Результат прижимается к MIN_DECIMAL или MAX_DECIMAL
+    OVERFLOW_FLAG // Результат по модулю 2^N и признак overflowed(), который наследуют результаты операций
+};
+
+// Признак переполнения хранится только в политике OVERFLOW_FLAG;
+// в остальных политиках база пустая и не увеличивает размер числа
+template <bool STORED> struct OverflowFlag {
+    bool overflow = false;
+};
+
+template <> struct OverflowFlag<false> {};
+
+// Класс для представления N-битного бинарного числа в дополнительном коде.
+// Переполнение определяется по флагам настоящей машинной арифметики
+// (__builtin_*_overflow) и обрабатывается по политике POLICY.
+// Десятичное значение не хранится: оно получается из битов при выводе.
+// Все операции constexpr: выражение из констант вычисляется при компиляции,
+// а исключение (переполнение, деление на ноль) становится ошибкой компиляции.
+template <int N, OverflowPolicy POLICY = OVERFLOW_WRAP>
+class Binary : private OverflowFlag<POLICY == OVERFLOW_FLAG> {
+public:
+    typedef typename BinaryStorage<N>::Word Word;
+    typedef typename BinaryStorage<N>::Signed Signed;
+
+    // Размер бинарного числа
+    static constexpr int BINARY_SIZE = N;
+    // Политика переполнения
+    static constexpr OverflowPolicy OVERFLOW_POLICY = POLICY;
+    // Бросается ли исключение при переполнении
+    static constexpr bool IS_CHECKED = POLICY == OVERFLOW_THROW;
+    // Маска всех битов числа
+    static constexpr Word MASK = static_cast<Word>(~Word(0));
+    // Маска знакового (старшего) бита
+    static constexpr Word SIGN_BIT = static_cast<Word>(Word(1) << (N - 1));
+    // Минимальное и максимальное десятичное число, которое можно представить
+    static constexpr long long MIN_DECIMAL = -static_cast<long long>(SIGN_BIT - 1) - 1;
+    static constexpr long long MAX_DECIMAL = static_cast<long long>(SIGN_BIT - 1);
+
+private:
+    Word bits; // Машинное слово с битами числа (бит 0 - младший)
+
+    // Функция для инвертирования всех битов (дополнение до 1)
+    constexpr void negate() {
+        bits = static_cast<Word>(~bits);
+    }
+
+    // Функция для сдвига битов влево на заданное количество позиций
+    constexpr void shift_bits(unsigned int shift) {
+        bits = shift < BINARY_SIZE ? static_cast<Word>(bits << shift) : Word(0);
+    }
+
+    // Обработка переполнения результата по политике.
+    // positive - знак точного (бесконечной разрядности) результата,
+    // нужен для насыщения
+    constexpr void settle(bool overflow, bool positive) {
+        if constexpr (POLICY == OVERFLOW_THROW) {
+            if (overflow) {
+                throw std::runtime_error("Overflow...");
+            }
+        } else if constexpr (POLICY == OVERFLOW_SATURATE) {
+            if (overflow) {
+                bits = positive ? static_cast<Word>(SIGN_BIT - 1) : SIGN_BIT;
+            }
+        } else if constexpr (POLICY == OVERFLOW_FLAG) {
+            this->overflow = this->overflow || overflow;
+        }
+        (void)overflow;
+        (void)positive;
+    }
+
+    // Деление модулей без восстановления остатка: на каждом шаге к сдвинутому
+    // частичному остатку прибавляется или вычитается делитель по знаку
+    // остатка, бит частного - знак нового остатка. В конце отрицательный
+    // остаток исправляется одним сложением. divisor != 0
+    static constexpr void divideMagnitudes(Word dividend, Word divisor, Word& quotient, Word& remainder) {
+        typedef typename BinaryStorage<N>::Wide Wide;
+        Wide partial = 0;
+        Word digits = 0;
+        for (int i = N - 1; i >= 0; i--) {
+            Wide next = static_cast<Wide>(partial * 2 + ((dividend >> i) & 1));
+            partial = partial >= 0 ? static_cast<Wide>(next - divisor) : static_cast<Wide>(next + divisor);
+            digits = static_cast<Word>((digits << 1) | (partial >= 0 ? 1 : 0));
+        }
+        if (partial < 0) {
+            partial = static_cast<Wide>(partial + divisor);
+        }
+        quotient = digits;
+        remainder = static_cast<Word>(partial);
+    }
+
+    // Модуль числа (для минимального числа - SIGN_BIT, он помещается в Word)
+    constexpr Word magnitude() const {
+        return (bits & SIGN_BIT) ? static_cast<Word>(0 - bits) : bits;
+    }
+
+    // Величина сдвига: неотрицательное значение count
+    static constexpr unsigned int shiftCount(const Binary& count) {
+        if (count.bits & SIGN_BIT) {
+            throw std::runtime_error("Invalid shift");
+        }
+        return count.bits < static_cast<Word>(BINARY_SIZE) ? static_cast<unsigned int>(count.bits) : BINARY_SIZE;
+    }
+
+    // Признак переполнения операндов переходит к результату (OVERFLOW_FLAG)
+    constexpr void inherit(const Binary& a, const Binary& b) {
+        if constexpr (POLICY == OVERFLOW_FLAG) {
+            this->overflow = a.overflow || b.overflow;
+        }
+        (void)a;
+        (void)b;
+    }
+
+public:
+    // Конструктор по умолчанию
+    constexpr Binary() : bits(0) {
+        INSTRUMENT_COUNT(binaryConstructions);
+    }
+
+    // Конструктор с параметром - десятичное число
+    constexpr Binary(long long _decimal) : bits(static_cast<Word>(_decimal)) {
+        INSTRUMENT_COUNT(binaryConstructions);
+        if (_decimal < MIN_DECIMAL || _decimal > MAX_DECIMAL) {
+            throw std::runtime_error("Decimal is too large!");
+        }
+    }
+
+    // Создание числа из готового машинного слова
+    static constexpr Binary fromWord(Word word) {
+        Binary result;
+        result.bits = word;
+        return result;
+    }
+
+    // Машинное слово с битами числа
+    constexpr Word word() const {
+        return bits;
+    }
+
+    // Десятичное представление числа
+    constexpr long long decimal() const {
+        return static_cast<Signed>(bits);
+    }
+
+    // Было ли переполнение при вычислении числа (только OVERFLOW_FLAG)
+    constexpr bool overflowed() const {
+        if constexpr (POLICY == OVERFLOW_FLAG) {
+            return this->overflow;
+        } else {
+            return false;
+        }
+    }
+
+    // Оператор вывода в поток
+    friend std::ostream& operator<<(std::ostream& os, const Binary& b) {
+        char text[BINARY_SIZE];
+        for (int i = 0; i < BINARY_SIZE; i++) {
+            text[i] = static_cast<char>('0' + ((b.bits >> (BINARY_SIZE - 1 - i)) & 1));
+        }
+        os.write(text, BINARY_SIZE);
+        os << " (" << b.decimal() << ")";
+        if (b.overflowed()) {
+            os << " [overflow]";
+        }
+        return os;
+    }
+
+    // Оператор сложения
+    constexpr Binary operator+(const Binary& other) const {
+        INSTRUMENT_COUNT(additions);
+        Binary result;
+        if constexpr (POLICY == OVERFLOW_WRAP) {
+            result.bits = static_cast<Word>(bits + other.bits);
+        } else {
+            Signed sum = 0;
+            bool overflow = __builtin_add_overflow(static_cast<Signed>(bits), static_cast<Signed>(other.bits), &sum);
+            result.bits = static_cast<Word>(sum);
+            result.inherit(*this, other);
+            // При переполнении сложения знак точной суммы совпадает со знаком слагаемых
+            result.settle(overflow, (bits & SIGN_BIT) == 0);
+        }
+        return result;
+    }
+
+    // Унарный оператор минус (инвертирование)
+    constexpr Binary operator-() const {
+        Binary result(*this);
+        result.negate();
+        result.bits = static_cast<Word>(result.bits + 1);
+        // Переполнение только у минимального числа, точный результат положителен
+        result.settle(bits == SIGN_BIT, true);
+        return result;
+    }
+
+    // Оператор вычитания
+    constexpr Binary operator-(const Binary& other) const {
+        Binary result;
+        if constexpr (POLICY == OVERFLOW_WRAP) {
+            result.bits = static_cast<Word>(bits - other.bits);
+        } else {
+            Signed difference = 0;
+            bool overflow = __builtin_sub_overflow(static_cast<Signed>(bits), static_cast<Signed>(other.bits), &difference);
+            result.bits = static_cast<Word>(difference);
+            result.inherit(*this, other);
+            // При переполнении вычитания знак точной разности совпадает со знаком уменьшаемого
+            result.settle(overflow, (bits & SIGN_BIT) == 0);
+        }
+        return result;
+    }
+
+    // Оператор умножения
+    constexpr Binary operator*(const Binary& other) const {
+        INSTRUMENT_COUNT(multiplications);
+        Binary result;
+        if constexpr (POLICY == OVERFLOW_WRAP) {
+            result.bits = static_cast<Word>(static_cast<unsigned long long>(bits) * other.bits);
+        } else {
+            Signed product = 0;
+            bool overflow = __builtin_mul_overflow(static_cast<Signed>(bits), static_cast<Signed>(other.bits), &product);
+            result.bits = static_cast<Word>(product);
+            result.inherit(*this, other);
+            // Знак точного произведения - по знакам сомножителей
+            result.settle(overflow, ((bits ^ other.bits) & SIGN_BIT) == 0);
+        }
+        return result;
+    }
+
+    // Оператор деления (с отбрасыванием дробной части, как в C++)
+    constexpr Binary operator/(const Binary& other) const {
+        if (other.bits == 0) {
+            throw std::runtime_error("Division by zero");
+        }
+        Word quotient = 0, remainder = 0;
+        divideMagnitudes(magnitude(), other.magnitude(), quotient, remainder);
+        bool negativeResult = ((bits ^ other.bits) & SIGN_BIT) != 0;
+        Binary result = fromWord(negativeResult ? static_cast<Word>(0 - quotient) : quotient);
+        result.inherit(*this, other);
+        // Переполнение только у MIN / -1, точное частное положительно
+        result.settle(!negativeResult && (result.bits & SIGN_BIT) != 0, true);
+        return result;
+    }
+
+    // Оператор остатка от деления (знак как у делимого)
+    constexpr Binary operator%(const Binary& other) const {
+        if (other.bits == 0) {
+            throw std::runtime_error("Division by zero");
+        }
+        Word quotient = 0, remainder = 0;
+        divideMagnitudes(magnitude(), other.magnitude(), quotient, remainder);
+        Binary result = fromWord((bits & SIGN_BIT) ? static_cast<Word>(0 - remainder) : remainder);
+        result.inherit(*this, other);
+        return result;
+    }
+
+    // Сдвиг влево; переполнение - если потерян значащий бит или изменился знак
+    constexpr Binary operator<<(const Binary& count) const {
+        unsigned int shift = shiftCount(count);
+        Binary result(*this);
+        result.inherit(*this, count);
+        result.shift_bits(shift);
+        if constexpr (POLICY != OVERFLOW_WRAP) {
+            Binary back(result);
+            bool overflow = shift == BINARY_SIZE ? bits != 0 : (back >> count).bits != bits;
+            result.settle(overflow, (bits & SIGN_BIT) == 0);
+        }
+        return result;
+    }
+
+    // Арифметический сдвиг вправо (старшие биты заполняются знаком)
+    constexpr Binary operator>>(const Binary& count) const {
+        unsigned int shift = shiftCount(count);
+        Binary result(*this);
+        result.inherit(*this, count);
+        if (shift == BINARY_SIZE) {
+            result.bits = (bits & SIGN_BIT) ? MASK : Word(0);
+        } else {
+            result.bits = static_cast<Word>(static_cast<Signed>(bits) >> shift);
+        }
+        return result;
+    }
+
+    // Логический сдвиг вправо (старшие биты заполняются нулями)
+    constexpr Binary logicalShiftRight(const Binary& count) const {
+        unsigned int shift = shiftCount(count);
+        Binary result(*this);
+        result.inherit(*this, count);
+        result.bits = shift == BINARY_SIZE ? Word(0) : static_cast<Word>(bits >> shift);
+        return result;
+    }
+
+    // Побитовые операции
+    constexpr Binary operator&(const Binary& other) const {
+        Binary result = fromWord(static_cast<Word>(bits & other.bits));
+        result.inherit(*this, other);
+        return result;
+    }
+
+    constexpr Binary operator|(const Binary& other) const {
+        Binary result = fromWord(static_cast<Word>(bits | other.bits));
+        result.inherit(*this, other);
+        return result;
+    }
+
+    constexpr Binary operator^(const Binary& other) const {
+        Binary result = fromWord(static_cast<Word>(bits ^ other.bits));
+        result.inherit(*this, other);
+        return result;
+    }
+
+    constexpr Binary operator~() const {
+        Binary result(*this);
+        result.negate();
+        return result;
+    }
+
+    // Операторы сравнения
+    constexpr bool operator==(const Binary& other) const {
+        return bits == other.bits;
+    }
+
+    constexpr bool operator!=(const Binary& other) const {
+        return bits != other.bits;
+    }
+};
+
+// Стандартные разрядности
+typedef Binary<8> Binary8;
+typedef Binary<16> Binary16;
+typedef Binary<32> Binary32;
+typedef Binary<64> Binary64;
+
+#endif
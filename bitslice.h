@@ -0,0 +1,439 @@
+#ifndef BITSLICE_H
+#define BITSLICE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "batch.h"
+#include "binary.h"
+#include "bytecode.h"
+#include "columnar.h"
+#include "format.h"
+#include "mapped_file.h"
+#include "tokenizer.h"
+
+// Количество дорожек в битовом срезе (битов в uint64_t)
+const size_t BITSLICE_LANES = 64;
+
+// Битовый срез: 64 N-битных числа, уложенных "поперек".
+// planes[i] содержит бит i всех 64 чисел: бит L слова planes[i] - это
+// бит i числа в дорожке L. Операции - логические схемы над словами,
+// каждая логическая операция обрабатывает сразу 64 числа.
+template <int N>
+struct BitSliced {
+    uint64_t planes[N];
+
+    // Все дорожки равны одному числу
+    static BitSliced broadcast(uint64_t word) {
+        BitSliced result;
+        for (int i = 0; i < N; i++) {
+            result.planes[i] = ((word >> i) & 1) ? ~uint64_t(0) : 0;
+        }
+        return result;
+    }
+
+    // Укладка до 64 чисел поперек (остальные дорожки - нули)
+    template <class Lane>
+    static BitSliced fromLanes(const Lane* values, size_t count) {
+        BitSliced result;
+        for (int i = 0; i < N; i++) {
+            result.planes[i] = 0;
+        }
+        for (size_t lane = 0; lane < count; lane++) {
+            uint64_t word = static_cast<uint64_t>(values[lane]);
+            for (int i = 0; i < N; i++) {
+                result.planes[i] |= ((word >> i) & 1) << lane;
+            }
+        }
+        return result;
+    }
+
+    // Обратное преобразование: числа первых count дорожек
+    template <class Lane>
+    void toLanes(Lane* values, size_t count) const {
+        typedef typename BinaryStorage<N>::Word Word;
+        for (size_t lane = 0; lane < count; lane++) {
+            Word word = 0;
+            for (int i = 0; i < N; i++) {
+                word = static_cast<Word>(word | (((planes[i] >> lane) & 1) << i));
+            }
+            values[lane] = static_cast<Lane>(word);
+        }
+    }
+};
+
+// Сумматор с последовательным переносом над M битовыми плоскостями:
+// out = a + b + carry (перенос - маска дорожек, где он равен 1).
+// Плоскости ниже from не меняются (в out должны быть уже записаны).
+template <int M>
+inline void bitSlicedAdd(const uint64_t* a, const uint64_t* b, uint64_t carry, uint64_t* out, int from = 0) {
+    for (int i = from; i < M; i++) {
+        uint64_t half = a[i] ^ b[i];
+        uint64_t sum = half ^ carry;
+        carry = (a[i] & b[i]) | (half & carry);
+        out[i] = sum;
+    }
+}
+
+// Умножение по модулю 2^M: для каждого бита j множителя сдвинутое на j
+// множимое, маскированное дорожками, где бит j равен 1, прибавляется
+// к сумме начиная с плоскости j
+template <int M>
+inline void bitSlicedMultiply(const uint64_t* a, const uint64_t* b, uint64_t* out) {
+    uint64_t partial[M];
+    for (int i = 0; i < M; i++) {
+        out[i] = 0;
+    }
+    for (int j = 0; j < M; j++) {
+        if (b[j] == 0) {
+            continue;
+        }
+        for (int i = j; i < M; i++) {
+            partial[i] = a[i - j] & b[j];
+        }
+        bitSlicedAdd<M>(out, partial, 0, out, j);
+    }
+}
+
+// Сложение по модулю 2^N
+template <int N>
+inline BitSliced<N> operator+(const BitSliced<N>& a, const BitSliced<N>& b) {
+    BitSliced<N> result;
+    bitSlicedAdd<N>(a.planes, b.planes, 0, result.planes);
+    return result;
+}
+
+// Дорожки с переполнением при сложении
+template <int N>
+inline uint64_t addOverflow(const BitSliced<N>& a, const BitSliced<N>& b, const BitSliced<N>& sum) {
+    // Знаки слагаемых совпадают, а знак суммы другой
+    return (a.planes[N - 1] ^ sum.planes[N - 1]) & (b.planes[N - 1] ^ sum.planes[N - 1]);
+}
+
+// Вычитание: a + ~b + 1
+template <int N>
+inline BitSliced<N> operator-(const BitSliced<N>& a, const BitSliced<N>& b) {
+    BitSliced<N> inverted, result;
+    for (int i = 0; i < N; i++) {
+        inverted.planes[i] = ~b.planes[i];
+    }
+    bitSlicedAdd<N>(a.planes, inverted.planes, ~uint64_t(0), result.planes);
+    return result;
+}
+
+// Дорожки с переполнением при вычитании
+template <int N>
+inline uint64_t subOverflow(const BitSliced<N>& a, const BitSliced<N>& b, const BitSliced<N>& difference) {
+    // Знаки операндов разные, а знак разности не как у уменьшаемого
+    return (a.planes[N - 1] ^ b.planes[N - 1]) & (a.planes[N - 1] ^ difference.planes[N - 1]);
+}
+
+// Изменение знака: ~a + 1 (переполнение - только у минимального числа,
+// у него знак сохраняется)
+template <int N>
+inline BitSliced<N> operator-(const BitSliced<N>& a) {
+    BitSliced<N> zero = BitSliced<N>::broadcast(0);
+    return zero - a;
+}
+
+// Сдвиг всех дорожек влево на shift битов: плоскости сдвигаются целиком
+template <int N>
+inline BitSliced<N> shiftLeft(const BitSliced<N>& a, int shift) {
+    BitSliced<N> result;
+    for (int i = 0; i < N; i++) {
+        result.planes[i] = i >= shift ? a.planes[i - shift] : 0;
+    }
+    return result;
+}
+
+// Умножение по модулю 2^N
+template <int N>
+inline BitSliced<N> operator*(const BitSliced<N>& a, const BitSliced<N>& b) {
+    BitSliced<N> result;
+    bitSlicedMultiply<N>(a.planes, b.planes, result.planes);
+    return result;
+}
+
+// Умножение с поиском переполнения: сомножители расширяются знаком до 2N
+// битов, произведение в 2N битах точное; переполнение - в дорожках, где
+// старшие N битов произведения не совпадают со знаком младшей половины
+template <int N>
+inline BitSliced<N> multiplyChecked(const BitSliced<N>& a, const BitSliced<N>& b, uint64_t& overflow) {
+    uint64_t wideA[2 * N], wideB[2 * N], product[2 * N];
+    for (int i = 0; i < 2 * N; i++) {
+        wideA[i] = a.planes[i < N ? i : N - 1];
+        wideB[i] = b.planes[i < N ? i : N - 1];
+    }
+    bitSlicedMultiply<2 * N>(wideA, wideB, product);
+    BitSliced<N> result;
+    overflow = 0;
+    for (int i = 0; i < N; i++) {
+        result.planes[i] = product[i];
+        overflow |= product[N + i] ^ product[N - 1];
+    }
+    return result;
+}
+
+// Вычислитель байт-кода на битовых срезах: 64 строки значений за проход.
+// Интерфейс такой же, как у ColumnarEvaluator, семантика - как у
+// Binary<N, POLICY>: при OVERFLOW_THROW дорожки с переполнением помечаются
+// ошибкой, при OVERFLOW_WRAP результат по модулю 2^N.
+template <class Number>
+class BitSlicedEvaluator {
+    static_assert(Number::OVERFLOW_POLICY == OVERFLOW_WRAP || Number::OVERFLOW_POLICY == OVERFLOW_THROW,
+                  "BitSlicedEvaluator supports OVERFLOW_WRAP and OVERFLOW_THROW only");
+
+public:
+    typedef typename Number::Signed Lane;
+    static constexpr int N = Number::BINARY_SIZE;
+
+private:
+    std::vector<Instruction> code; // Инструкции
+    std::vector<BitSliced<N>> constants; // Константы, размноженные на все дорожки
+    size_t depth; // Максимальная глубина стека
+    size_t variableCount; // Количество переменных
+
+    // Количество переменных по инструкциям OP_VAR
+    static size_t countVariables(const std::vector<Instruction>& code) {
+        size_t count = 0;
+        for (const Instruction& instruction : code) {
+            if (instruction.op == OP_VAR && instruction.operand >= count) {
+                count = instruction.operand + 1;
+            }
+        }
+        return count;
+    }
+
+public:
+    // Формула с переменными
+    explicit BitSlicedEvaluator(const CompiledExpression<Number>& expression)
+        : code(expression.instructions()), depth(expression.maxDepth()), variableCount(countVariables(code)) {
+        for (const Number& constant : expression.constantPool()) {
+            constants.push_back(BitSliced<N>::broadcast(constant.word()));
+        }
+    }
+
+    // Готовый байт-код без констант (все операнды - переменные)
+    BitSlicedEvaluator(std::vector<Instruction> _code, size_t _depth) : code(std::move(_code)), depth(_depth), variableCount(countVariables(code)) {}
+
+    // Вычисление по столбцам: columns[v][row] - значение переменной v в строке row.
+    // results[row] - результат; errors[row] != 0 - в строке переполнение
+    void evaluate(const Lane* const* columns, size_t rows, Lane* results, uint8_t* errors) const {
+        std::vector<BitSliced<N>> stack(depth);
+        std::vector<BitSliced<N>> variables(variableCount);
+
+        for (size_t start = 0; start < rows; start += BITSLICE_LANES) {
+            size_t lanes = std::min(BITSLICE_LANES, rows - start);
+            // Переменные укладываются поперек один раз на 64 строки
+            for (size_t v = 0; v < variables.size(); v++) {
+                variables[v] = BitSliced<N>::fromLanes(columns[v] + start, lanes);
+            }
+
+            uint64_t overflow = 0; // Дорожки, где было переполнение
+            size_t top = 0;
+            for (const Instruction& instruction : code) {
+                switch (instruction.op) {
+                    case OP_CONST:
+                        stack[top++] = constants[instruction.operand];
+                        break;
+                    case OP_VAR:
+                        stack[top++] = variables[instruction.operand];
+                        break;
+                    case OP_ADD: {
+                        top--;
+                        BitSliced<N> sum = stack[top - 1] + stack[top];
+                        if (Number::IS_CHECKED) overflow |= addOverflow(stack[top - 1], stack[top], sum);
+                        stack[top - 1] = sum;
+                        break;
+                    }
+                    case OP_SUB: {
+                        top--;
+                        BitSliced<N> difference = stack[top - 1] - stack[top];
+                        if (Number::IS_CHECKED) overflow |= subOverflow(stack[top - 1], stack[top], difference);
+                        stack[top - 1] = difference;
+                        break;
+                    }
+                    case OP_MUL: {
+                        top--;
+                        if (Number::IS_CHECKED) {
+                            uint64_t lanesOverflow;
+                            stack[top - 1] = multiplyChecked(stack[top - 1], stack[top], lanesOverflow);
+                            overflow |= lanesOverflow;
+                        } else {
+                            stack[top - 1] = stack[top - 1] * stack[top];
+                        }
+                        break;
+                    }
+                }
+            }
+
+            stack[0].toLanes(results + start, lanes);
+            for (size_t lane = 0; lane < lanes; lane++) {
+                errors[start + lane] = static_cast<uint8_t>((overflow >> lane) & 1);
+            }
+        }
+    }
+};
+
+// Формула с переменными на битовых срезах (вывод как у --formula)
+template <class Number>
+BatchStats runBitSlicedInput(const std::string& inputFile, std::ostream& out, const CompiledExpression<Number>& formula,
+                             FormatMode mode = FORMAT_BINARY) {
+    return runColumnarInput<Number, BitSlicedEvaluator<Number>>(inputFile, out, formula, mode);
+}
+
+// Выражения длиннее этого вычисляются по одному: литералы 64 выражений
+// такой длины уже не помещаются в кэш
+const size_t BITSLICE_MAX_TOKENS = 4096;
+
+// Разбор выражения в форму: shape - токены, где литерал заменен на 'L',
+// literals - значения литералов по порядку. false - выражение некорректно
+// или литерал вне диапазона (такое выражение вычисляется обычным способом,
+// чтобы ошибка была той же, что и у evaluatePostfix)
+template <class Number>
+bool parseShape(std::string_view line, std::string& shape, std::vector<typename Number::Signed>& literals) {
+    shape.clear();
+    literals.clear();
+    Tokenizer tokenizer(line);
+    std::string_view token;
+    size_t size = 0;
+    while (tokenizer.next(token)) {
+        if (shape.size() == BITSLICE_MAX_TOKENS) {
+            return false;
+        }
+        if (token == "+" || token == "-" || token == "*") {
+            if (size < 2) {
+                return false;
+            }
+            size--;
+            shape += token[0];
+            continue;
+        }
+        int value;
+        if (!parseInt(token, value) || value < Number::MIN_DECIMAL || value > Number::MAX_DECIMAL) {
+            return false;
+        }
+        shape += 'L';
+        literals.push_back(static_cast<typename Number::Signed>(value));
+        size++;
+    }
+    return size == 1;
+}
+
+// Пакетная обработка выражений с литералами: подряд идущие выражения одной
+// формы (одинаковые операции на одних местах) собираются по 64 и
+// вычисляются за один проход на битовых срезах, литерал k становится
+// переменной k. Остальные выражения вычисляются функцией fallback
+// (обычно evaluatePostfix<Number>). Вывод такой же, как у runBatch.
+template <class Number, class Evaluate>
+BatchStats runBitSlicedBatch(std::string_view text, std::ostream& stream, Evaluate fallback, FormatMode mode = FORMAT_BINARY) {
+    typedef typename Number::Signed Lane;
+
+    BatchStats stats;
+    auto start = std::chrono::steady_clock::now();
+    OutputBuffer out(stream, mode);
+
+    std::string groupShape; // Форма выражений группы
+    std::vector<std::vector<Lane>> groupLiterals(BITSLICE_LANES); // Литералы каждого выражения группы
+    size_t groupSize = 0;
+    std::string shape;
+    std::vector<Lane> literals;
+    std::vector<std::vector<Lane>> columns;
+    std::vector<const Lane*> columnPointers;
+    Lane results[BITSLICE_LANES];
+    uint8_t errors[BITSLICE_LANES];
+
+    // Вычисление и вывод накопленной группы
+    auto flush = [&]() {
+        if (groupSize == 0) {
+            return;
+        }
+        std::vector<Instruction> code;
+        size_t size = 0, depth = 0, literal = 0;
+        for (char c : groupShape) {
+            if (c == 'L') {
+                code.push_back(Instruction{OP_VAR, static_cast<uint32_t>(literal++)});
+                depth = std::max(depth, ++size);
+            } else {
+                code.push_back(Instruction{c == '+' ? OP_ADD : c == '-' ? OP_SUB : OP_MUL, 0});
+                size--;
+            }
+        }
+        columns.resize(literal);
+        columnPointers.resize(literal);
+        for (size_t k = 0; k < literal; k++) {
+            columns[k].resize(groupSize);
+            for (size_t lane = 0; lane < groupSize; lane++) {
+                columns[k][lane] = groupLiterals[lane][k];
+            }
+            columnPointers[k] = columns[k].data();
+        }
+
+        BitSlicedEvaluator<Number>(std::move(code), depth).evaluate(columnPointers.data(), groupSize, results, errors);
+        for (size_t lane = 0; lane < groupSize; lane++) {
+            stats.expressions++;
+            stats.tokens += groupShape.size();
+            if (errors[lane]) {
+                stats.failed++;
+                out.appendError("Overflow...");
+            } else {
+                out.appendResult(Number::fromWord(static_cast<typename Number::Word>(results[lane])));
+            }
+        }
+        groupSize = 0;
+    };
+
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == text.size() ? end : end + 1);
+
+        if (!parseShape<Number>(line, shape, literals)) {
+            flush();
+            evaluateLine(line, out, stats, fallback);
+            continue;
+        }
+        if (groupSize > 0 && shape != groupShape) {
+            flush();
+        }
+        if (groupSize == 0) {
+            groupShape.swap(shape);
+        }
+        groupLiterals[groupSize++].swap(literals);
+        if (groupSize == BITSLICE_LANES) {
+            flush();
+        }
+    }
+    flush();
+    out.flush();
+    stream.flush();
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Пакетный режим на битовых срезах для файла (отображается в память)
+// или стандартного ввода
+template <class Number, class Evaluate>
+BatchStats runBitSlicedBatchInput(const std::string& inputFile, std::ostream& out, Evaluate fallback,
+                                  FormatMode mode = FORMAT_BINARY) {
+    if (!inputFile.empty()) {
+        MappedFile mapped(inputFile);
+        return runBitSlicedBatch<Number>(mapped.view(), out, fallback, mode);
+    }
+    std::string text((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    return runBitSlicedBatch<Number>(text, out, fallback, mode);
+}
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "tokenizer.h"
+
+// Код операции байт-кода
+enum Opcode : uint8_t {
+    OP_CONST, // Положить в стек константу constants[operand]
+    OP_VAR, // Положить в стек значение переменной номер operand
+    OP_ADD, // Сложение двух верхних элементов
+    OP_SUB, // Вычитание двух верхних элементов
+    OP_MUL // Умножение двух верхних элементов
+};
+
+// Инструкция байт-кода
+struct Instruction {
+    Opcode op; // Код операции
+    uint32_t operand; // Номер константы или переменной
+};
+
+// Проверка, что токен - имя переменной (буква или '_', затем буквы, цифры, '_')
+inline bool isIdentifier(std::string_view token) {
+    auto letter = [](char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; };
+    if (token.empty() || !letter(token[0])) {
+        return false;
+    }
+    for (char c : token) {
+        if (!letter(c) && !(c >= '0' && c <= '9')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Постфиксное выражение, один раз скомпилированное в байт-код.
+// Операнды - литералы или именованные переменные (например, "x y + 3 *").
+// Глубина стека вычисляется при компиляции, поэтому вычисление идет
+// на массиве фиксированного размера без проверок границ и выделений памяти.
+template <class Number>
+class CompiledExpression {
+    std::vector<Instruction> code; // Инструкции
+    std::vector<Number> constants; // Константы, посчитанные при компиляции
+    std::vector<std::string> variables; // Имена переменных в порядке первого появления
+    size_t depth; // Максимальная глубина стека
+
+    CompiledExpression() : depth(0) {}
+
+    // Номер переменной по имени (добавляется, если ее еще нет)
+    size_t addVariable(std::string_view name) {
+        for (size_t i = 0; i < variables.size(); i++) {
+            if (variables[i] == name) {
+                return i;
+            }
+        }
+        variables.emplace_back(name);
+        return variables.size() - 1;
+    }
+
+public:
+    // Компиляция выражения; некорректное выражение - исключение
+    static CompiledExpression compile(std::string_view expression) {
+        CompiledExpression result;
+        Tokenizer tokenizer(expression);
+        std::string_view token;
+        size_t size = 0;
+
+        while (tokenizer.next(token)) {
+            if (token == "+" || token == "-" || token == "*") {
+                if (size < 2) throw std::runtime_error("Invalid expression");
+                size--;
+                Opcode op = token == "+" ? OP_ADD : token == "-" ? OP_SUB : OP_MUL;
+                result.code.push_back(Instruction{op, 0});
+                continue;
+            }
+
+            int value;
+            if (parseInt(token, value)) {
+                result.code.push_back(Instruction{OP_CONST, static_cast<uint32_t>(result.constants.size())});
+                result.constants.push_back(Number(value));
+            } else if (isIdentifier(token)) {
+                result.code.push_back(Instruction{OP_VAR, static_cast<uint32_t>(result.addVariable(token))});
+            } else {
+                throw std::runtime_error("Invalid token: " + std::string(token));
+            }
+            size++;
+            if (size > result.depth) {
+                result.depth = size;
+            }
+        }
+
+        if (size != 1) throw std::runtime_error("Invalid expression");
+        return result;
+    }
+
+    // Имена переменных; значения передаются в evaluate в этом порядке
+    const std::vector<std::string>& variableNames() const {
+        return variables;
+    }
+
+    // Максимальная глубина стека
+    size_t maxDepth() const {
+        return depth;
+    }
+
+    // Инструкции байт-кода
+    const std::vector<Instruction>& instructions() const {
+        return code;
+    }
+
+    // Константы байт-кода
+    const std::vector<Number>& constantPool() const {
+        return constants;
+    }
+
+    // Вычисление на стеке, предоставленном вызывающим (не меньше maxDepth() элементов)
+    Number evaluate(const Number* bindings, Number* stack) const {
+        Number* top = stack;
+        for (const Instruction& instruction : code) {
+            switch (instruction.op) {
+                case OP_CONST:
+                    *top++ = constants[instruction.operand];
+                    break;
+                case OP_VAR:
+                    *top++ = bindings[instruction.operand];
+                    break;
+                case OP_ADD:
+                    top--;
+                    top[-1] = top[-1] + top[0];
+                    break;
+                case OP_SUB:
+                    top--;
+                    top[-1] = top[-1] - top[0];
+                    break;
+                case OP_MUL:
+                    top--;
+                    top[-1] = top[-1] * top[0];
+                    break;
+            }
+        }
+        return stack[0];
+    }
+
+    // Вычисление при заданных значениях переменных. Стек потока растет
+    // до maxDepth() один раз и переиспользуется между вызовами
+    Number evaluate(const Number* bindings) const {
+        thread_local std::vector<Number> stack;
+        if (stack.size() < depth) {
+            stack.resize(depth);
+        }
+        return evaluate(bindings, stack.data());
+    }
+
+    // Вычисление по многим наборам значений: строка i набора - это
+    // bindings[i * variableNames().size() ...]. Стек выделяется один раз.
+    void evaluateMany(const Number* bindings, size_t rows, Number* results) const {
+        std::vector<Number> stack(depth);
+        size_t width = variables.size();
+        for (size_t i = 0; i < rows; i++) {
+            results[i] = evaluate(bindings + i * width, stack.data());
+        }
+    }
+};
+
+// Вычислитель формулы для пакетного режима: строка входа - значения
+// переменных через пробел в порядке variableNames()
+template <class Number>
+class FormulaEvaluator {
+    CompiledExpression<Number> formula; // Скомпилированная формула
+
+public:
+    explicit FormulaEvaluator(CompiledExpression<Number> _formula) : formula(std::move(_formula)) {}
+
+    Number operator()(std::string_view line) const {
+        thread_local std::vector<Number> bindings; // Буфер значений переиспользуется между строками
+        bindings.clear();
+        Tokenizer tokenizer(line);
+        std::string_view token;
+        while (tokenizer.next(token)) {
+            int value;
+            if (!parseInt(token, value)) throw std::runtime_error("Invalid token: " + std::string(token));
+            bindings.push_back(Number(value));
+        }
+        if (bindings.size() != formula.variableNames().size()) {
+            throw std::runtime_error("Expected " + std::to_string(formula.variableNames().size()) + " values");
+        }
+        return formula.evaluate(bindings.data());
+    }
+};
+
+#endif
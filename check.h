@@ -0,0 +1,29 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <string>
+#include "evaluation.h"
+#include "format.h"
+
+// Общие части программ дифференциальной проверки (jitcheck.cpp,
+// streamcheck.cpp, forkjoincheck.cpp): исходы вычислений сравниваются
+// как строки
+
+// Значение в двоичной записи
+template <class Number>
+std::string outcome(const Number& value) {
+    std::string text;
+    appendNumber(text, value, FORMAT_BINARY);
+    return text;
+}
+
+// Значение или причина и смещение ошибки
+template <class Number>
+std::string outcome(const EvaluationResult<Number>& result) {
+    if (result) {
+        return outcome(result.value());
+    }
+    return "error " + std::to_string(result.error().code) + " at " + std::to_string(result.error().offset);
+}
+
+#endif
@@ -0,0 +1,218 @@
+// Нагрузочный клиент сервера вычислений (2.cpp --serve путь).
+// Каждое соединение - отдельный поток; выражения шлются конвейером, не больше
+// --pipeline неотвеченных на соединение. С --verify каждый ответ сверяется
+// с локальным evaluatePostfix<Binary32> (сервер должен быть запущен без --big).
+// Сборка: g++ -O2 -std=c++17 -pthread client.cpp -o client
+// Запуск: client --socket путь [--connections C] [--count N] [--pipeline P]
+//                [--tokens T] [--depth D] [--seed S] [--verify]
+#define POSTFIX_NO_MAIN
+#include "2.cpp"
+#undef POSTFIX_NO_MAIN
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "generator.h"
+#include "server.h"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Параметры нагрузки
+struct ClientOptions {
+    std::string socketPath; // Путь к сокету сервера
+    size_t connections = 4; // Одновременных соединений
+    size_t count = 100000; // Выражений на соединение
+    size_t pipeline = 256; // Наибольшее число неотвеченных выражений на соединение
+    bool verify = false; // Сверка ответов с локальным вычислением
+    GeneratorOptions generator;
+};
+
+// Итоги одного соединения
+struct ClientResult {
+    size_t expressions = 0; // Получено ответов
+    size_t errors = 0; // Ответов "Error: ..."
+    size_t mismatches = 0; // Ответов, не совпавших с локальным вычислением
+    std::vector<double> latencies; // Задержки ответов, мкс
+    std::string failure; // Ошибка соединения
+};
+
+// Ожидаемый ответ сервера на выражение
+std::string expectedAnswer(std::string_view expression) {
+    std::ostringstream out;
+    try {
+        out << evaluatePostfix<Binary32>(expression);
+    } catch (const std::exception& e) {
+        out << "Error: " << e.what();
+    }
+    return out.str();
+}
+
+// Одно соединение: отправка count выражений и прием ответов
+void runConnection(const ClientOptions& options, uint64_t seed, ClientResult& result) {
+    typedef std::chrono::steady_clock Clock;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        result.failure = std::string("Cannot connect: ") + std::strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    GeneratorOptions generatorOptions = options.generator;
+    generatorOptions.seed = seed;
+    ExpressionGenerator generator(generatorOptions);
+    struct Sent {
+        Clock::time_point time; // Время отправки
+        std::string expected; // Ожидаемый ответ (при --verify)
+    };
+    std::deque<Sent> inFlight; // Отправленные выражения без ответа
+    std::string expression, request, response;
+    std::vector<char> buffer(64 * 1024);
+    size_t sent = 0;
+    result.latencies.reserve(options.count);
+
+    while (result.expressions < options.count) {
+        // Дозаполнение конвейера одной записью
+        request.clear();
+        while (sent < options.count && inFlight.size() < options.pipeline) {
+            generator.generate(expression);
+            request += expression;
+            request += '\n';
+            inFlight.push_back(Sent{Clock::now(), options.verify ? expectedAnswer(expression) : std::string()});
+            sent++;
+        }
+        for (size_t offset = 0; offset < request.size();) {
+            ssize_t count = send(fd, request.data() + offset, request.size() - offset, MSG_NOSIGNAL);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0) {
+                result.failure = std::string("Send failed: ") + std::strerror(errno);
+                close(fd);
+                return;
+            }
+            offset += static_cast<size_t>(count);
+        }
+
+        // Прием хотя бы одного ответа
+        ssize_t count = recv(fd, buffer.data(), buffer.size(), 0);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            result.failure = count == 0 ? "Server closed connection" : std::string("Receive failed: ") + std::strerror(errno);
+            close(fd);
+            return;
+        }
+        response.append(buffer.data(), static_cast<size_t>(count));
+        Clock::time_point now = Clock::now();
+        std::string_view payload;
+        size_t frameBytes, consumed = 0;
+        while (parseFrame(std::string_view(response).substr(consumed), payload, frameBytes)) {
+            consumed += frameBytes;
+            if (inFlight.empty()) {
+                result.failure = "Unexpected response";
+                close(fd);
+                return;
+            }
+            const Sent& oldest = inFlight.front();
+            result.latencies.push_back(std::chrono::duration<double>(now - oldest.time).count() * 1e6);
+            if (payload.substr(0, 6) == "Error:") {
+                result.errors++;
+            }
+            if (options.verify && payload != oldest.expected) {
+                result.mismatches++;
+            }
+            result.expressions++;
+            inFlight.pop_front();
+        }
+        response.erase(0, consumed);
+    }
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        ClientOptions options;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--socket" && hasValue) options.socketPath = argv[++i];
+            else if (arg == "--connections" && hasValue) options.connections = std::stoull(argv[++i]);
+            else if (arg == "--count" && hasValue) options.count = std::stoull(argv[++i]);
+            else if (arg == "--pipeline" && hasValue) options.pipeline = std::max<size_t>(1, std::stoull(argv[++i]));
+            else if (arg == "--tokens" && hasValue) options.generator.tokens = std::stoull(argv[++i]);
+            else if (arg == "--depth" && hasValue) options.generator.maxDepth = std::stoull(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.generator.seed = std::stoull(argv[++i]);
+            else if (arg == "--verify") options.verify = true;
+            else throw std::runtime_error("Unknown argument: " + arg);
+        }
+        if (options.socketPath.empty()) {
+            throw std::runtime_error("Socket path is required (--socket)");
+        }
+
+        std::vector<ClientResult> results(options.connections);
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < options.connections; i++) {
+            threads.emplace_back(runConnection, std::cref(options), options.generator.seed + i, std::ref(results[i]));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        ClientResult total;
+        for (ClientResult& result : results) {
+            if (!result.failure.empty()) {
+                std::cerr << "Error: " << result.failure << std::endl;
+            }
+            total.expressions += result.expressions;
+            total.errors += result.errors;
+            total.mismatches += result.mismatches;
+            total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+        }
+        std::sort(total.latencies.begin(), total.latencies.end());
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Received " << total.expressions << " answers (" << total.errors << " errors";
+        if (options.verify) {
+            std::cout << ", " << total.mismatches << " mismatches";
+        }
+        std::cout << ") over " << options.connections << " connections in " << seconds << " s: "
+                  << std::setprecision(0) << total.expressions / (seconds > 0 ? seconds : 1e-9) << " expressions/s, "
+                  << std::setprecision(2) << "latency p50 " << percentile(total.latencies, 0.50)
+                  << " us, p99 " << percentile(total.latencies, 0.99)
+                  << " us, p999 " << percentile(total.latencies, 0.999) << " us" << std::endl;
+        return total.mismatches == 0 && total.expressions == options.connections * options.count ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+#else
+
+int main() {
+    std::cerr << "Error: Client is supported only on Linux" << std::endl;
+    return 1;
+}
+
+#endif
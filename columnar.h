@@ -0,0 +1,500 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "binary.h"
+#include "batch.h"
+#include "bytecode.h"
+#include "format.h"
+#include "mapped_file.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLUMNAR_X86 1
+#include <immintrin.h>
+#endif
+
+// Набор команд, которым пользуются столбцовые ядра
+enum SimdLevel {
+    SIMD_SCALAR, // Обычный скалярный код
+    SIMD_SSE41, // 128-битные регистры (SSE4.1)
+    SIMD_AVX2 // 256-битные регистры (AVX2)
+};
+
+// Определение лучшего доступного набора команд (один раз при первом вызове)
+inline SimdLevel detectSimdLevel() {
+#ifdef COLUMNAR_X86
+    static const SimdLevel level = __builtin_cpu_supports("avx2") ? SIMD_AVX2
+                                 : __builtin_cpu_supports("sse4.1") ? SIMD_SSE41
+                                 : SIMD_SCALAR;
+    return level;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+// Скалярные ядра: операция над столбцами a и b длины n с записью в out.
+// overflow[i] становится ненулевым, если в строке i результат не помещается
+// в тип Lane (так же, как определяет переполнение Binary<N, OVERFLOW_THROW>).
+template <class Lane>
+struct ScalarColumnKernels {
+    static void add(const Lane* a, const Lane* b, Lane* out, uint8_t* overflow, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            Lane r;
+            overflow[i] |= __builtin_add_overflow(a[i], b[i], &r);
+            out[i] = r;
+        }
+    }
+
+    static void sub(const Lane* a, const Lane* b, Lane* out, uint8_t* overflow, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            Lane r;
+            overflow[i] |= __builtin_sub_overflow(a[i], b[i], &r);
+            out[i] = r;
+        }
+    }
+
+    static void mul(const Lane* a, const Lane* b, Lane* out, uint8_t* overflow, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            Lane r;
+            overflow[i] |= __builtin_mul_overflow(a[i], b[i], &r);
+            out[i] = r;
+        }
+    }
+};
+
+// Ядра для разрядности без векторной реализации - только скалярные
+template <class Lane>
+struct ColumnKernels : ScalarColumnKernels<Lane> {
+    static void add(SimdLevel, const Lane* a, const Lane* b, Lane* out, uint8_t* overflow, size_t n) {
+        ScalarColumnKernels<Lane>::add(a, b, out, overflow, n);
+    }
+    static void sub(SimdLevel, const Lane* a, const Lane* b, Lane* out, uint8_t* overflow, size_t n) {
+        ScalarColumnKernels<Lane>::sub(a, b, out, overflow, n);
+    }
+    static void mul(SimdLevel, const Lane* a, const Lane* b, Lane* out, uint8_t* overflow, size_t n) {
+        ScalarColumnKernels<Lane>::mul(a, b, out, overflow, n);
+    }
+};
+
+#ifdef COLUMNAR_X86
+
+// 32-битные ядра: сложение, вычитание и умножение по модулю 2^32, как у Binary32.
+// Переполнение в знаковом смысле для сложения и вычитания определяется
+// по знаковым битам, для умножения - скалярно (только если оно нужно).
+template <>
+struct ColumnKernels<int32_t> {
+    __attribute__((target("avx2")))
+    static void addAvx2(const int32_t* a, const int32_t* b, int32_t* out, uint8_t* overflow, size_t n, bool sub) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i r = sub ? _mm256_sub_epi32(x, y) : _mm256_add_epi32(x, y);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+            // Знаковый бит: (x ^ r) & (y ^ r) для сложения, (x ^ y) & (x ^ r) для вычитания
+            __m256i bad = sub ? _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(x, r))
+                              : _mm256_and_si256(_mm256_xor_si256(x, r), _mm256_xor_si256(y, r));
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(bad));
+            if (mask != 0) {
+                for (int k = 0; k < 8; k++) {
+                    overflow[i + k] |= (mask >> k) & 1;
+                }
+            }
+        }
+        if (sub) {
+            ScalarColumnKernels<int32_t>::sub(a + i, b + i, out + i, overflow + i, n - i);
+        } else {
+            ScalarColumnKernels<int32_t>::add(a + i, b + i, out + i, overflow + i, n - i);
+        }
+    }
+
+    __attribute__((target("sse4.1")))
+    static void addSse(const int32_t* a, const int32_t* b, int32_t* out, uint8_t* overflow, size_t n, bool sub) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i r = sub ? _mm_sub_epi32(x, y) : _mm_add_epi32(x, y);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+            __m128i bad = sub ? _mm_and_si128(_mm_xor_si128(x, y), _mm_xor_si128(x, r))
+                              : _mm_and_si128(_mm_xor_si128(x, r), _mm_xor_si128(y, r));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(bad));
+            if (mask != 0) {
+                for (int k = 0; k < 4; k++) {
+                    overflow[i + k] |= (mask >> k) & 1;
+                }
+            }
+        }
+        if (sub) {
+            ScalarColumnKernels<int32_t>::sub(a + i, b + i, out + i, overflow + i, n - i);
+        } else {
+            ScalarColumnKernels<int32_t>::add(a + i, b + i, out + i, overflow + i, n - i);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static void mulAvx2(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_mullo_epi32(x, y));
+        }
+        for (; i < n; i++) {
+            out[i] = static_cast<int32_t>(static_cast<uint32_t>(a[i]) * static_cast<uint32_t>(b[i]));
+        }
+    }
+
+    __attribute__((target("sse4.1")))
+    static void mulSse(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_mullo_epi32(x, y));
+        }
+        for (; i < n; i++) {
+            out[i] = static_cast<int32_t>(static_cast<uint32_t>(a[i]) * static_cast<uint32_t>(b[i]));
+        }
+    }
+
+    static void add(SimdLevel level, const int32_t* a, const int32_t* b, int32_t* out, uint8_t* overflow, size_t n) {
+        if (level == SIMD_AVX2) addAvx2(a, b, out, overflow, n, false);
+        else if (level == SIMD_SSE41) addSse(a, b, out, overflow, n, false);
+        else ScalarColumnKernels<int32_t>::add(a, b, out, overflow, n);
+    }
+
+    static void sub(SimdLevel level, const int32_t* a, const int32_t* b, int32_t* out, uint8_t* overflow, size_t n) {
+        if (level == SIMD_AVX2) addAvx2(a, b, out, overflow, n, true);
+        else if (level == SIMD_SSE41) addSse(a, b, out, overflow, n, true);
+        else ScalarColumnKernels<int32_t>::sub(a, b, out, overflow, n);
+    }
+
+    // overflow == nullptr - переполнение умножения не нужно (режим с переносом)
+    static void mul(SimdLevel level, const int32_t* a, const int32_t* b, int32_t* out, uint8_t* overflow, size_t n) {
+        if (overflow != nullptr) {
+            ScalarColumnKernels<int32_t>::mul(a, b, out, overflow, n);
+        } else if (level == SIMD_AVX2) {
+            mulAvx2(a, b, out, n);
+        } else if (level == SIMD_SSE41) {
+            mulSse(a, b, out, n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                out[i] = static_cast<int32_t>(static_cast<uint32_t>(a[i]) * static_cast<uint32_t>(b[i]));
+            }
+        }
+    }
+};
+
+// 8-битные ядра с контролем переполнения, как у Binary<8, OVERFLOW_THROW>.
+// Сложение и вычитание сравнивают результат с насыщением и с переносом,
+// умножение выполняется в 16-битных словах с проверкой, что произведение
+// помещается в 8 бит.
+template <>
+struct ColumnKernels<int8_t> {
+    __attribute__((target("avx2")))
+    static void addAvx2(const int8_t* a, const int8_t* b, int8_t* out, uint8_t* overflow, size_t n, bool sub) {
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i wrapped = sub ? _mm256_sub_epi8(x, y) : _mm256_add_epi8(x, y);
+            __m256i saturated = sub ? _mm256_subs_epi8(x, y) : _mm256_adds_epi8(x, y);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), wrapped);
+            __m256i flags = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(overflow + i));
+            __m256i bad = _mm256_andnot_si256(_mm256_cmpeq_epi8(wrapped, saturated), _mm256_set1_epi8(1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(overflow + i), _mm256_or_si256(flags, bad));
+        }
+        if (sub) {
+            ScalarColumnKernels<int8_t>::sub(a + i, b + i, out + i, overflow + i, n - i);
+        } else {
+            ScalarColumnKernels<int8_t>::add(a + i, b + i, out + i, overflow + i, n - i);
+        }
+    }
+
+    __attribute__((target("sse4.1")))
+    static void addSse(const int8_t* a, const int8_t* b, int8_t* out, uint8_t* overflow, size_t n, bool sub) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i wrapped = sub ? _mm_sub_epi8(x, y) : _mm_add_epi8(x, y);
+            __m128i saturated = sub ? _mm_subs_epi8(x, y) : _mm_adds_epi8(x, y);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), wrapped);
+            __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(overflow + i));
+            __m128i bad = _mm_andnot_si128(_mm_cmpeq_epi8(wrapped, saturated), _mm_set1_epi8(1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(overflow + i), _mm_or_si128(flags, bad));
+        }
+        if (sub) {
+            ScalarColumnKernels<int8_t>::sub(a + i, b + i, out + i, overflow + i, n - i);
+        } else {
+            ScalarColumnKernels<int8_t>::add(a + i, b + i, out + i, overflow + i, n - i);
+        }
+    }
+
+    // 16 произведений за шаг: расширение до 16 бит, младший байт - результат,
+    // переполнение - если 16-битное произведение не равно расширению этого байта
+    __attribute__((target("avx2")))
+    static void mulAvx2(const int8_t* a, const int8_t* b, int8_t* out, uint8_t* overflow, size_t n) {
+        size_t i = 0;
+        const __m256i lowByte = _mm256_set1_epi16(0x00FF);
+        for (; i + 16 <= n; i += 16) {
+            __m256i x = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+            __m256i y = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+            __m256i p = _mm256_mullo_epi16(x, y);
+            __m256i fits = _mm256_cmpeq_epi16(p, _mm256_srai_epi16(_mm256_slli_epi16(p, 8), 8));
+            __m256i low = _mm256_and_si256(p, lowByte);
+            __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(low), _mm256_extracti128_si256(low, 1));
+            __m256i badWords = _mm256_andnot_si256(fits, _mm256_set1_epi16(1));
+            __m128i bad = _mm_packus_epi16(_mm256_castsi256_si128(badWords), _mm256_extracti128_si256(badWords, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+            __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(overflow + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(overflow + i), _mm_or_si128(flags, bad));
+        }
+        ScalarColumnKernels<int8_t>::mul(a + i, b + i, out + i, overflow + i, n - i);
+    }
+
+    __attribute__((target("sse4.1")))
+    static void mulSse(const int8_t* a, const int8_t* b, int8_t* out, uint8_t* overflow, size_t n) {
+        size_t i = 0;
+        const __m128i lowByte = _mm_set1_epi16(0x00FF);
+        for (; i + 16 <= n; i += 16) {
+            __m128i xa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i yb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i p0 = _mm_mullo_epi16(_mm_cvtepi8_epi16(xa), _mm_cvtepi8_epi16(yb));
+            __m128i p1 = _mm_mullo_epi16(_mm_cvtepi8_epi16(_mm_srli_si128(xa, 8)), _mm_cvtepi8_epi16(_mm_srli_si128(yb, 8)));
+            __m128i fits0 = _mm_cmpeq_epi16(p0, _mm_srai_epi16(_mm_slli_epi16(p0, 8), 8));
+            __m128i fits1 = _mm_cmpeq_epi16(p1, _mm_srai_epi16(_mm_slli_epi16(p1, 8), 8));
+            __m128i bytes = _mm_packus_epi16(_mm_and_si128(p0, lowByte), _mm_and_si128(p1, lowByte));
+            __m128i bad = _mm_packus_epi16(_mm_andnot_si128(fits0, _mm_set1_epi16(1)), _mm_andnot_si128(fits1, _mm_set1_epi16(1)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+            __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(overflow + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(overflow + i), _mm_or_si128(flags, bad));
+        }
+        ScalarColumnKernels<int8_t>::mul(a + i, b + i, out + i, overflow + i, n - i);
+    }
+
+    static void add(SimdLevel level, const int8_t* a, const int8_t* b, int8_t* out, uint8_t* overflow, size_t n) {
+        if (level == SIMD_AVX2) addAvx2(a, b, out, overflow, n, false);
+        else if (level == SIMD_SSE41) addSse(a, b, out, overflow, n, false);
+        else ScalarColumnKernels<int8_t>::add(a, b, out, overflow, n);
+    }
+
+    static void sub(SimdLevel level, const int8_t* a, const int8_t* b, int8_t* out, uint8_t* overflow, size_t n) {
+        if (level == SIMD_AVX2) addAvx2(a, b, out, overflow, n, true);
+        else if (level == SIMD_SSE41) addSse(a, b, out, overflow, n, true);
+        else ScalarColumnKernels<int8_t>::sub(a, b, out, overflow, n);
+    }
+
+    static void mul(SimdLevel level, const int8_t* a, const int8_t* b, int8_t* out, uint8_t* overflow, size_t n) {
+        if (level == SIMD_AVX2) mulAvx2(a, b, out, overflow, n);
+        else if (level == SIMD_SSE41) mulSse(a, b, out, overflow, n);
+        else ScalarColumnKernels<int8_t>::mul(a, b, out, overflow, n);
+    }
+};
+
+#endif
+
+// Столбцовый вычислитель: одна скомпилированная формула применяется к
+// столбцам значений переменных целиком. Каждая операция +, -, * выполняется
+// векторным ядром над блоком строк; набор команд выбирается при запуске.
+// Семантика совпадает с Binary<N, POLICY>: при OVERFLOW_THROW строки, в которых
+// случилось переполнение, помечаются ошибкой, при OVERFLOW_WRAP результат
+// берется по модулю 2^N (другие политики не поддерживаются).
+template <class Number>
+class ColumnarEvaluator {
+    static_assert(Number::OVERFLOW_POLICY == OVERFLOW_WRAP || Number::OVERFLOW_POLICY == OVERFLOW_THROW,
+                  "ColumnarEvaluator supports OVERFLOW_WRAP and OVERFLOW_THROW only");
+
+public:
+    typedef typename Number::Signed Lane;
+
+    // Количество строк, обрабатываемых за один проход по формуле (блок в кэше)
+    static constexpr size_t BLOCK_ROWS = 2048;
+
+private:
+    const CompiledExpression<Number>& expression; // Формула
+    SimdLevel level; // Набор команд
+
+public:
+    explicit ColumnarEvaluator(const CompiledExpression<Number>& _expression, SimdLevel _level = detectSimdLevel())
+        : expression(_expression), level(_level) {}
+
+    // Вычисление по столбцам: columns[v][row] - значение переменной v в строке row.
+    // results[row] - результат; errors[row] != 0 - в строке переполнение
+    // (заполняется только для OVERFLOW_THROW, иначе обнуляется).
+    void evaluate(const Lane* const* columns, size_t rows, Lane* results, uint8_t* errors) const {
+        const std::vector<Instruction>& code = expression.instructions();
+        const std::vector<Number>& constants = expression.constantPool();
+        size_t depth = expression.maxDepth();
+
+        // Буферы стека, флаги переполнения и размноженные константы выделяются один раз
+        std::vector<Lane> scratch(depth * BLOCK_ROWS);
+        std::vector<const Lane*> stack(depth);
+        std::vector<Lane> constantColumns(constants.size() * BLOCK_ROWS);
+        for (size_t c = 0; c < constants.size(); c++) {
+            std::fill_n(constantColumns.begin() + static_cast<std::ptrdiff_t>(c * BLOCK_ROWS), BLOCK_ROWS,
+                        static_cast<Lane>(constants[c].word()));
+        }
+        std::vector<uint8_t> ignored(Number::IS_CHECKED ? 0 : BLOCK_ROWS);
+
+        for (size_t start = 0; start < rows; start += BLOCK_ROWS) {
+            size_t n = std::min(BLOCK_ROWS, rows - start);
+            uint8_t* overflow = Number::IS_CHECKED ? errors + start : ignored.data();
+            std::fill_n(overflow, n, 0);
+            size_t top = 0;
+
+            for (const Instruction& instruction : code) {
+                if (instruction.op == OP_CONST) {
+                    stack[top++] = constantColumns.data() + instruction.operand * BLOCK_ROWS;
+                    continue;
+                }
+                if (instruction.op == OP_VAR) {
+                    stack[top++] = columns[instruction.operand] + start;
+                    continue;
+                }
+                top--;
+                const Lane* a = stack[top - 1];
+                const Lane* b = stack[top];
+                Lane* out = scratch.data() + (top - 1) * BLOCK_ROWS;
+                if (instruction.op == OP_ADD) {
+                    ColumnKernels<Lane>::add(level, a, b, out, overflow, n);
+                } else if (instruction.op == OP_SUB) {
+                    ColumnKernels<Lane>::sub(level, a, b, out, overflow, n);
+                } else {
+                    mul(a, b, out, overflow, n);
+                }
+                stack[top - 1] = out;
+            }
+            std::memcpy(results + start, stack[0], n * sizeof(Lane));
+            if (!Number::IS_CHECKED) {
+                std::fill_n(errors + start, n, 0);
+            }
+        }
+    }
+
+private:
+    // Умножение: для режима с переносом переполнение умножения не считается
+    void mul(const Lane* a, const Lane* b, Lane* out, uint8_t* overflow, size_t n) const {
+#ifdef COLUMNAR_X86
+        if (std::is_same<Lane, int32_t>::value) {
+            ColumnKernels<Lane>::mul(level, a, b, out, Number::IS_CHECKED ? overflow : nullptr, n);
+            return;
+        }
+#endif
+        ColumnKernels<Lane>::mul(level, a, b, out, overflow, n);
+    }
+};
+
+// Столбцовый пакетный режим для формулы с переменными: строки входа - значения
+// переменных, они собираются в столбцы блоками и вычисляются векторными ядрами.
+// Вывод такой же, как у построчного режима --formula. Evaluator - вычислитель
+// с интерфейсом ColumnarEvaluator (например, на битовых срезах).
+template <class Number, class Evaluator = ColumnarEvaluator<Number>>
+BatchStats runColumnarText(std::string_view text, std::ostream& stream, const CompiledExpression<Number>& formula,
+                           FormatMode mode = FORMAT_BINARY) {
+    typedef typename Number::Signed Lane;
+    const size_t ROWS = 64 * 1024; // Строк в одной порции столбцов
+
+    BatchStats stats;
+    auto start = std::chrono::steady_clock::now();
+    OutputBuffer out(stream, mode);
+    size_t width = formula.variableNames().size();
+    Evaluator evaluator(formula);
+
+    std::vector<std::vector<Lane>> columns(width, std::vector<Lane>(ROWS));
+    std::vector<const Lane*> columnPointers(width);
+    std::vector<Lane> results(ROWS);
+    std::vector<uint8_t> errors(ROWS);
+    std::vector<std::string> parseErrors(ROWS); // Ошибка разбора строки (пусто - строка корректна)
+
+    while (!text.empty()) {
+        // Разбор порции строк в столбцы
+        size_t rows = 0;
+        for (; rows < ROWS && !text.empty(); rows++) {
+            size_t end = text.find('\n');
+            if (end == std::string_view::npos) {
+                end = text.size();
+            }
+            std::string_view line = text.substr(0, end);
+            text.remove_prefix(end == text.size() ? end : end + 1);
+            stats.tokens += countTokens(line);
+
+            parseErrors[rows].clear();
+            Tokenizer tokenizer(line);
+            std::string_view token;
+            size_t count = 0;
+            while (tokenizer.next(token)) {
+                int value;
+                if (!parseInt(token, value)) {
+                    parseErrors[rows] = "Invalid token: " + std::string(token);
+                    break;
+                }
+                if (value < Number::MIN_DECIMAL || value > Number::MAX_DECIMAL) {
+                    parseErrors[rows] = "Decimal is too large!";
+                    break;
+                }
+                if (count < width) {
+                    columns[count][rows] = static_cast<Lane>(value);
+                }
+                count++;
+            }
+            if (parseErrors[rows].empty() && count != width) {
+                parseErrors[rows] = "Expected " + std::to_string(width) + " values";
+            }
+            if (!parseErrors[rows].empty()) {
+                // Некорректная строка вычисляется на нулях, результат не выводится
+                for (size_t v = 0; v < width; v++) {
+                    columns[v][rows] = 0;
+                }
+            }
+        }
+
+        for (size_t v = 0; v < width; v++) {
+            columnPointers[v] = columns[v].data();
+        }
+        evaluator.evaluate(columnPointers.data(), rows, results.data(), errors.data());
+
+        for (size_t row = 0; row < rows; row++) {
+            stats.expressions++;
+            if (!parseErrors[row].empty()) {
+                stats.failed++;
+                out.appendError(parseErrors[row]);
+            } else if (errors[row]) {
+                stats.failed++;
+                out.appendError("Overflow...");
+            } else {
+                out.appendResult(Number::fromWord(static_cast<typename Number::Word>(results[row])));
+            }
+        }
+    }
+    out.flush();
+    stream.flush();
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Столбцовый режим для файла (отображается в память) или стандартного ввода
+template <class Number, class Evaluator = ColumnarEvaluator<Number>>
+BatchStats runColumnarInput(const std::string& inputFile, std::ostream& out, const CompiledExpression<Number>& formula,
+                            FormatMode mode = FORMAT_BINARY) {
+    if (!inputFile.empty()) {
+        MappedFile mapped(inputFile);
+        return runColumnarText<Number, Evaluator>(mapped.view(), out, formula, mode);
+    }
+    std::string text((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    return runColumnarText<Number, Evaluator>(text, out, formula, mode);
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef CONSTANT_H
+#define CONSTANT_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "binary.h"
+#include "operators.h"
+#include "tokenizer.h"
+
+// Вычисление постфиксного выражения при компиляции. Формула, записанная в
+// коде строковым литералом, сворачивается в константу, а ошибка в ней
+// (неверный токен, нехватка операндов, переполнение при OVERFLOW_THROW,
+// деление на ноль) - это исключение в константном вычислении, то есть
+// ошибка компиляции. Подходят числа Binary; BigBinary хранит разряды
+// в куче и вычисляется только во время выполнения.
+
+// Наибольшая глубина стека по умолчанию (стек - массив без выделений памяти)
+const size_t CONSTANT_STACK_DEPTH = 64;
+
+// Вычисление выражения; годится и для constexpr, и для обычного вызова
+// (тогда ошибки - исключения с теми же сообщениями, что у evaluatePostfix)
+template <class Number, size_t DEPTH = CONSTANT_STACK_DEPTH>
+constexpr Number evaluatePostfixConstant(std::string_view expression) {
+    Number stack[DEPTH] = {};
+    size_t depth = 0;
+    size_t pos = 0;
+    while (true) {
+        while (pos < expression.size() && isSpace(expression[pos])) {
+            pos++;
+        }
+        if (pos == expression.size()) {
+            break;
+        }
+        size_t start = pos;
+        while (pos < expression.size() && !isSpace(expression[pos])) {
+            pos++;
+        }
+        std::string_view token = expression.substr(start, pos - start);
+
+        char op = binaryOperatorCode(token);
+        if (op != 0) {
+            if (depth < 2) throw std::runtime_error("Invalid expression");
+            stack[depth - 2] = applyBinaryOperator(op, stack[depth - 2], stack[depth - 1]);
+            depth--;
+        } else if (isNotOperator(token)) {
+            if (depth == 0) throw std::runtime_error("Invalid expression");
+            stack[depth - 1] = ~stack[depth - 1];
+        } else {
+            int value = 0;
+            if (!parseIntConstant(token, value)) throw std::runtime_error("Invalid token: " + std::string(token));
+            if (depth == DEPTH) throw std::runtime_error("Expression is too deep");
+            stack[depth++] = Number(value);
+        }
+    }
+    if (depth != 1) throw std::runtime_error("Invalid expression");
+    return stack[0];
+}
+
+#ifdef __cpp_consteval
+// C++20: вычисление только при компиляции
+template <class Number, size_t DEPTH = CONSTANT_STACK_DEPTH>
+consteval Number evaluatePostfixConsteval(std::string_view expression) {
+    return evaluatePostfixConstant<Number, DEPTH>(expression);
+}
+#endif
+
+// Константа из литерала выражения, вычисленная при компиляции и в C++17:
+// POSTFIX_CONSTANT(Binary32, "x 2 *") не компилируется, а
+// POSTFIX_CONSTANT(Binary32, "6 7 *") - готовое число без вычислений при выполнении
+#define POSTFIX_CONSTANT(Number, expression)                                            \
+    ([]() {                                                                             \
+        constexpr Number postfixConstant = evaluatePostfixConstant<Number>(expression); \
+        return postfixConstant;                                                         \
+    }())
+
+#endif
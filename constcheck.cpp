@@ -0,0 +1,76 @@
+// Проверка вычисления выражений при компиляции (constant.h): все проверки -
+// static_assert, поэтому программа, которая собралась, их уже прошла.
+// Ошибки в формуле (деление на ноль, переполнение при OVERFLOW_THROW,
+// неверный токен) проверяются признаком IsPostfixConstant: выражение с
+// ошибкой не является константным, и специализация признака отбрасывается.
+// Сборка: g++ -O2 -std=c++17 -pthread constcheck.cpp -o constcheck
+// Запуск: constcheck
+#define POSTFIX_NO_MAIN
+#include "2.cpp"
+#undef POSTFIX_NO_MAIN
+
+#include <iostream>
+#include <type_traits>
+
+// Вычисляется ли выражение EXPRESSION при компиляции без ошибки
+template <class Number, const char* EXPRESSION, class = void>
+struct IsPostfixConstant : std::false_type {};
+
+template <class Number, const char* EXPRESSION>
+struct IsPostfixConstant<Number, EXPRESSION,
+                         std::void_t<std::integral_constant<bool, (evaluatePostfixConstant<Number>(EXPRESSION), true)>>>
+    : std::true_type {};
+
+typedef Binary<8, OVERFLOW_THROW> Binary8Throw;
+typedef Binary<8, OVERFLOW_WRAP> Binary8Wrap;
+typedef Binary<8, OVERFLOW_SATURATE> Binary8Saturate;
+typedef Binary<8, OVERFLOW_FLAG> Binary8Flag;
+
+// Свертка формул в константы
+static_assert(POSTFIX_CONSTANT(Binary32, "6 7 *").decimal() == 42);
+static_assert(POSTFIX_CONSTANT(Binary32, "  1 2 +\n3 * ~ ").decimal() == ~9);
+static_assert(POSTFIX_CONSTANT(Binary32, "7 -2 / 7 -2 % -").decimal() == -4);
+static_assert(POSTFIX_CONSTANT(Binary32, "1 10 << 255 & 3 |").decimal() == 3);
+static_assert(POSTFIX_CONSTANT(Binary32, "-0042").decimal() == -42);
+
+// Переполнение в разных политиках
+static_assert(POSTFIX_CONSTANT(Binary8Wrap, "100 100 *").decimal() == 16);
+static_assert(POSTFIX_CONSTANT(Binary8Saturate, "100 100 *").decimal() == 127);
+static_assert(POSTFIX_CONSTANT(Binary8Saturate, "-100 100 *").decimal() == -128);
+static_assert(POSTFIX_CONSTANT(Binary8Flag, "100 100 *").overflowed());
+static_assert(!POSTFIX_CONSTANT(Binary8Flag, "100 27 +").overflowed());
+
+// Формулы с ошибкой не вычисляются при компиляции
+constexpr char PRODUCT[] = "6 7 *";
+constexpr char OVERFLOW[] = "100 100 *";
+constexpr char LITERAL_OVERFLOW[] = "200";
+constexpr char DIVISION_BY_ZERO[] = "1 0 /";
+constexpr char REMAINDER_BY_ZERO[] = "1 1 1 - %";
+constexpr char BAD_TOKEN[] = "x 2 *";
+constexpr char MISSING_OPERAND[] = "1 +";
+constexpr char EXTRA_OPERAND[] = "1 2";
+constexpr char EMPTY[] = " ";
+
+static_assert(IsPostfixConstant<Binary8Throw, PRODUCT>::value);
+static_assert(!IsPostfixConstant<Binary8Throw, OVERFLOW>::value);
+static_assert(IsPostfixConstant<Binary8Wrap, OVERFLOW>::value);
+static_assert(!IsPostfixConstant<Binary8Throw, LITERAL_OVERFLOW>::value);
+static_assert(!IsPostfixConstant<Binary32, DIVISION_BY_ZERO>::value);
+static_assert(!IsPostfixConstant<Binary8Wrap, REMAINDER_BY_ZERO>::value);
+static_assert(!IsPostfixConstant<Binary32, BAD_TOKEN>::value);
+static_assert(!IsPostfixConstant<Binary32, MISSING_OPERAND>::value);
+static_assert(!IsPostfixConstant<Binary32, EXTRA_OPERAND>::value);
+static_assert(!IsPostfixConstant<Binary32, EMPTY>::value);
+
+int main() {
+    // Та же функция во время выполнения: ошибка - исключение
+    try {
+        evaluatePostfixConstant<Binary32>(DIVISION_BY_ZERO);
+        std::cerr << "Division by zero is not reported" << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cout << "Runtime error: " << e.what() << std::endl;
+    }
+    std::cout << "Compile-time checks passed" << std::endl;
+    return 0;
+}
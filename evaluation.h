@@ -0,0 +1,170 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "bigbinary.h"
+#include "binary.h"
+#include "operators.h"
+
+// Вычисление без исключений: ошибка во входе возвращается как значение
+// (причина и место), а не бросается. Выражения с ошибками в пакетном режиме
+// встречаются часто, и раскрутка стека на каждой такой строке обходится
+// дороже самого вычисления.
+
+// Причина ошибки вычисления
+enum EvaluationErrorCode {
+    EVALUATION_OK, // Ошибки нет
+    EVALUATION_STACK_UNDERFLOW, // Операции не хватило операндов (или выражение пустое)
+    EVALUATION_LEFTOVER_OPERANDS, // После вычисления в стеке осталось больше одного числа
+    EVALUATION_BAD_TOKEN, // Токен не число и не операция
+    EVALUATION_LITERAL_RANGE, // Число не помещается в тип
+    EVALUATION_OVERFLOW, // Переполнение при политике OVERFLOW_THROW
+    EVALUATION_DIVISION_BY_ZERO, // Деление или остаток от деления на ноль
+    EVALUATION_INVALID_SHIFT, // Отрицательная величина сдвига
+    EVALUATION_SHIFT_TOO_LARGE, // Величина сдвига больше 32 бит или результат сдвига длиннее MAX_SHIFT_BITS (BigBinary)
+    EVALUATION_NEGATIVE_LOGICAL_SHIFT, // Логический сдвиг отрицательного числа (BigBinary)
+    EVALUATION_INVALID_PROGRAM // Испорченный код двоичной программы (program.h)
+};
+
+// Ошибка вычисления: причина, смещение токена в байтах от начала выражения
+// и сам токен (указывает в текст выражения). Ошибки в конце выражения
+// (EVALUATION_LEFTOVER_OPERANDS, пустое выражение) стоят на его конце с пустым токеном.
+struct EvaluationError {
+    EvaluationErrorCode code = EVALUATION_OK;
+    size_t offset = 0;
+    std::string_view token;
+
+    // Сообщение, как у исключения вычислителя с исключениями
+    std::string message() const {
+        switch (code) {
+            case EVALUATION_OK: return std::string();
+            case EVALUATION_STACK_UNDERFLOW:
+            case EVALUATION_LEFTOVER_OPERANDS: return "Invalid expression";
+            case EVALUATION_BAD_TOKEN: return "Invalid token: " + std::string(token);
+            case EVALUATION_LITERAL_RANGE: return "Decimal is too large!";
+            case EVALUATION_OVERFLOW: return "Overflow...";
+            case EVALUATION_DIVISION_BY_ZERO: return "Division by zero";
+            case EVALUATION_INVALID_SHIFT: return "Invalid shift";
+            case EVALUATION_SHIFT_TOO_LARGE: return "Shift is too large";
+            case EVALUATION_NEGATIVE_LOGICAL_SHIFT: return "Logical shift of a negative number";
+            case EVALUATION_INVALID_PROGRAM: return "Invalid program";
+        }
+        return std::string();
+    }
+};
+
+// Ошибка на токене token выражения expression (token - часть expression)
+inline EvaluationError evaluationError(EvaluationErrorCode code, std::string_view expression, std::string_view token) {
+    return EvaluationError{code, static_cast<size_t>(token.data() - expression.data()), token};
+}
+
+// Ошибка в конце выражения
+inline EvaluationError evaluationErrorAtEnd(EvaluationErrorCode code, std::string_view expression) {
+    return EvaluationError{code, expression.size(), expression.substr(expression.size())};
+}
+
+// Результат вычисления: число или ошибка
+template <class Number>
+class EvaluationResult {
+    Number number; // Результат (при ошибке - значение по умолчанию)
+    EvaluationError failure; // Ошибка (code == EVALUATION_OK, если ее нет)
+
+public:
+    EvaluationResult(Number _number) : number(std::move(_number)) {}
+
+    EvaluationResult(const EvaluationError& _failure) : number(), failure(_failure) {}
+
+    // Вычисление прошло без ошибки
+    explicit operator bool() const {
+        return failure.code == EVALUATION_OK;
+    }
+
+    const Number& value() const {
+        return number;
+    }
+
+    Number& value() {
+        return number;
+    }
+
+    const EvaluationError& error() const {
+        return failure;
+    }
+};
+
+// Является ли тип результатом вычисления без исключений
+template <class T> struct IsEvaluationResult : std::false_type {};
+template <class Number> struct IsEvaluationResult<EvaluationResult<Number>> : std::true_type {};
+
+// Число из литерала без исключения "Decimal is too large!"
+template <int N, OverflowPolicy POLICY>
+EvaluationErrorCode tryMakeNumber(long long decimal, Binary<N, POLICY>& result) {
+    typedef Binary<N, POLICY> Number;
+    if (decimal < Number::MIN_DECIMAL || decimal > Number::MAX_DECIMAL) {
+        return EVALUATION_LITERAL_RANGE;
+    }
+    result = Number(decimal);
+    return EVALUATION_OK;
+}
+
+inline EvaluationErrorCode tryMakeNumber(long long decimal, BigBinary& result) {
+    result = BigBinary(decimal);
+    return EVALUATION_OK;
+}
+
+// Является ли операция сдвигом
+inline bool isShiftOperator(char op) {
+    return op == OPERATOR_SHIFT_LEFT || op == OPERATOR_SHIFT_RIGHT || op == OPERATOR_LOGICAL_SHIFT_RIGHT;
+}
+
+// Бинарная операция без исключений: недопустимые операнды проверяются заранее,
+// а при OVERFLOW_THROW операция выполняется в политике OVERFLOW_FLAG
+// (те же условия переполнения, но вместо исключения - признак)
+template <int N, OverflowPolicy POLICY>
+EvaluationErrorCode tryApplyBinaryOperator(char op, const Binary<N, POLICY>& a, const Binary<N, POLICY>& b,
+                                           Binary<N, POLICY>& result) {
+    typedef Binary<N, POLICY> Number;
+    if ((op == '/' || op == '%') && b.word() == 0) {
+        return EVALUATION_DIVISION_BY_ZERO;
+    }
+    if (isShiftOperator(op) && (b.word() & Number::SIGN_BIT) != 0) {
+        return EVALUATION_INVALID_SHIFT;
+    }
+    if constexpr (POLICY == OVERFLOW_THROW) {
+        typedef Binary<N, OVERFLOW_FLAG> Flagged;
+        Flagged flagged = applyBinaryOperator(op, Flagged::fromWord(a.word()), Flagged::fromWord(b.word()));
+        if (flagged.overflowed()) {
+            return EVALUATION_OVERFLOW;
+        }
+        result = Number::fromWord(flagged.word());
+    } else {
+        result = applyBinaryOperator(op, a, b);
+    }
+    return EVALUATION_OK;
+}
+
+inline EvaluationErrorCode tryApplyBinaryOperator(char op, const BigBinary& a, const BigBinary& b, BigBinary& result) {
+    if ((op == '/' || op == '%') && b.size() == 0) {
+        return EVALUATION_DIVISION_BY_ZERO;
+    }
+    if (op == OPERATOR_LOGICAL_SHIFT_RIGHT && a.isNegative()) {
+        return EVALUATION_NEGATIVE_LOGICAL_SHIFT;
+    }
+    if (isShiftOperator(op) && b.isNegative()) {
+        return EVALUATION_INVALID_SHIFT;
+    }
+    if (isShiftOperator(op) && b.size() > 1) {
+        return EVALUATION_SHIFT_TOO_LARGE;
+    }
+    if (op == OPERATOR_SHIFT_LEFT && a.shiftTooLarge(b)) {
+        return EVALUATION_SHIFT_TOO_LARGE;
+    }
+    result = applyBinaryOperator(op, a, b);
+    return EVALUATION_OK;
+}
+
+#endif
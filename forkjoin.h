@@ -0,0 +1,318 @@
+#ifndef FORKJOIN_H
+#define FORKJOIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "batch.h"
+#include "evaluation.h"
+#include "operand_stack.h"
+#include "operators.h"
+#include "thread_pool.h"
+#include "tokenizer.h"
+
+// Параллельное вычисление одного большого выражения. Постфиксная запись
+// разбирается в компактное дерево: узлы лежат в постфиксном порядке, и
+// поддерево узла - это непрерывный отрезок массива, который заканчивается
+// этим узлом. Правый потомок узла - предыдущий узел, левый - узел перед
+// правым поддеревом. Независимые большие поддеревья вычисляются параллельно
+// (fork-join в пуле с перехватом работы), поддеревья не больше
+// FORK_JOIN_CUTOFF узлов - последовательно на стеке, как evaluatePostfix.
+
+// Узлов в поддереве, которое вычисляется последовательно
+const size_t FORK_JOIN_CUTOFF = 1 << 14;
+// Наименьший кусок текста для параллельного разбора на токены
+const size_t FORK_JOIN_PARSE_BYTES = 1 << 20;
+
+// Узел дерева выражения
+struct PostfixNode {
+    char op; // Код операции (operators.h), 0 - число
+    int32_t value; // Число
+    uint32_t size; // Узлов в поддереве с корнем в этом узле
+};
+
+// Ожидание флага done: пока задача не закончена, поток выполняет другие
+// задачи пула (в том числе вложенные), поэтому ожидание не блокирует пул
+inline void forkJoinWait(WorkStealingPool& pool, const std::atomic<bool>& done) {
+    while (!done.load(std::memory_order_acquire)) {
+        if (!pool.runPendingTask()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Выполнение task(i) для всех i < count задачами пула с ожиданием всех задач
+template <class Task>
+void forkJoinFor(WorkStealingPool& pool, size_t count, Task task) {
+    if (count == 1) {
+        task(0);
+        return;
+    }
+    std::atomic<size_t> remaining(count);
+    std::atomic<bool> done(false);
+    for (size_t i = 0; i < count; i++) {
+        pool.submit([&, i]() {
+            task(i);
+            if (--remaining == 0) {
+                done.store(true, std::memory_order_release);
+            }
+        });
+    }
+    forkJoinWait(pool, done);
+}
+
+// Результат поддерева: число или первая (в постфиксном порядке) ошибка
+template <class Number>
+struct SubtreeResult {
+    Number value;
+    size_t errorNode = std::numeric_limits<size_t>::max(); // Узел с ошибкой
+    EvaluationErrorCode code = EVALUATION_OK;
+
+    bool ok() const {
+        return code == EVALUATION_OK;
+    }
+
+    void fail(size_t node, EvaluationErrorCode _code) {
+        errorNode = node;
+        code = _code;
+    }
+};
+
+class PostfixTree {
+    std::string_view text; // Текст выражения (для места ошибки)
+    std::unique_ptr<PostfixNode[]> nodes; // Узлы в постфиксном порядке (память не обнуляется)
+    size_t count = 0; // Количество узлов
+
+    // Разбор куска текста в узлы, начиная с out (размеры поддеревьев пока
+    // не заданы); false - неверный токен
+    static bool tokenize(std::string_view piece, PostfixNode* out) {
+        Tokenizer tokenizer(piece);
+        std::string_view token;
+        while (tokenizer.next(token)) {
+            PostfixNode node{binaryOperatorCode(token), 0, 0};
+            if (node.op == 0 && isNotOperator(token)) {
+                node.op = OPERATOR_NOT;
+            } else if (node.op == 0 && !parseInt(token, node.value)) {
+                return false;
+            }
+            *out++ = node;
+        }
+        return true;
+    }
+
+    // Первый узел поддерева
+    size_t subtreeStart(size_t node) const {
+        return node + 1 - nodes[node].size;
+    }
+
+    // Последовательное вычисление поддерева на стеке
+    template <class Number>
+    SubtreeResult<Number> evaluateRange(size_t root) const {
+        thread_local OperandStack<Number> stack;
+        stack.clear();
+        SubtreeResult<Number> result;
+        if (nodes[root].size == 1) {
+            // Одно число (частый сосед в длинной цепочке операций)
+            EvaluationErrorCode code = tryMakeNumber(nodes[root].value, result.value);
+            if (code != EVALUATION_OK) {
+                result.fail(root, code);
+            }
+            return result;
+        }
+        for (size_t i = subtreeStart(root); i <= root; i++) {
+            const PostfixNode& node = nodes[i];
+            EvaluationErrorCode code = EVALUATION_OK;
+            if (node.op == 0) {
+                Number number;
+                code = tryMakeNumber(node.value, number);
+                stack.push(std::move(number));
+            } else if (node.op == OPERATOR_NOT) {
+                stack.push(~stack.pop());
+            } else {
+                Number b = stack.pop();
+                Number a = stack.pop();
+                Number value;
+                code = tryApplyBinaryOperator(node.op, a, b, value);
+                stack.push(std::move(value));
+            }
+            if (code != EVALUATION_OK) {
+                result.fail(i, code);
+                return result;
+            }
+        }
+        result.value = stack.pop();
+        return result;
+    }
+
+    // Применение бинарной операции узла к результатам потомков. Ошибка левого
+    // поддерева встретилась бы при последовательном вычислении раньше ошибки правого
+    template <class Number>
+    SubtreeResult<Number> combine(size_t node, SubtreeResult<Number>& left, SubtreeResult<Number>& right) const {
+        if (!left.ok()) return std::move(left);
+        if (!right.ok()) return std::move(right);
+        SubtreeResult<Number> result;
+        EvaluationErrorCode code = tryApplyBinaryOperator(nodes[node].op, left.value, right.value, result.value);
+        if (code != EVALUATION_OK) {
+            result.fail(node, code);
+        }
+        return result;
+    }
+
+    // Вычисление поддерева. Спуск идет по цепочке узлов, у которых большой
+    // только один потомок (глубина рекурсии не растет с длиной цепочки),
+    // до малого поддерева или узла с двумя большими потомками, которые
+    // вычисляются параллельно. На подъеме малые соседи вычисляются последовательно.
+    template <class Number>
+    SubtreeResult<Number> evaluateSubtree(size_t root, WorkStealingPool& pool, size_t cutoff) const {
+        std::vector<size_t> chain;
+        SubtreeResult<Number> result;
+        size_t node = root;
+        while (true) {
+            if (nodes[node].size <= cutoff) {
+                result = evaluateRange<Number>(node);
+                break;
+            }
+            if (nodes[node].op == OPERATOR_NOT) {
+                chain.push_back(node);
+                node--;
+                continue;
+            }
+            size_t right = node - 1;
+            size_t left = right - nodes[right].size;
+            bool bigLeft = nodes[left].size > cutoff;
+            bool bigRight = nodes[right].size > cutoff;
+            if (bigLeft && bigRight) {
+                SubtreeResult<Number> leftResult;
+                std::atomic<bool> done(false);
+                pool.submit([&]() {
+                    leftResult = evaluateSubtree<Number>(left, pool, cutoff);
+                    done.store(true, std::memory_order_release);
+                });
+                SubtreeResult<Number> rightResult = evaluateSubtree<Number>(right, pool, cutoff);
+                forkJoinWait(pool, done);
+                result = combine(node, leftResult, rightResult);
+                break;
+            }
+            chain.push_back(node);
+            node = bigLeft ? left : right;
+        }
+
+        for (size_t i = chain.size(); i-- > 0;) {
+            size_t parent = chain[i];
+            if (nodes[parent].op == OPERATOR_NOT) {
+                if (result.ok()) {
+                    result.value = ~result.value;
+                }
+                node = parent;
+                continue;
+            }
+            size_t right = parent - 1;
+            size_t left = right - nodes[right].size;
+            if (node == left) {
+                SubtreeResult<Number> sibling = evaluateRange<Number>(right);
+                result = combine(parent, result, sibling);
+            } else {
+                SubtreeResult<Number> sibling = evaluateRange<Number>(left);
+                result = combine(parent, sibling, result);
+            }
+            node = parent;
+        }
+        return result;
+    }
+
+public:
+    // Разбор выражения (куски текста разбираются на токены параллельно).
+    // false - выражение некорректно (неверный токен, нехватка или лишние
+    // операнды): такое выражение нужно вычислять обычным способом
+    bool parse(std::string_view expression, WorkStealingPool& pool) {
+        text = expression;
+        // Куски не меньше FORK_JOIN_PARSE_BYTES, границы сдвигаются к ближайшему разделителю
+        size_t pieces = std::min(expression.size() / FORK_JOIN_PARSE_BYTES, pool.size() * 4);
+        pieces = std::max<size_t>(pieces, 1);
+        std::vector<size_t> bounds(pieces + 1, expression.size());
+        bounds[0] = 0;
+        for (size_t i = 1; i < pieces; i++) {
+            size_t at = std::max(bounds[i - 1], expression.size() / pieces * i);
+            while (at < expression.size() && !isSpace(expression[at])) {
+                at++;
+            }
+            bounds[i] = at;
+        }
+        auto piece = [&](size_t i) { return expression.substr(bounds[i], bounds[i + 1] - bounds[i]); };
+
+        // Подсчет токенов в кусках, затем префиксные суммы - место каждого
+        // куска в массиве узлов, и разбор всех кусков сразу на свои места
+        std::vector<size_t> starts(pieces + 1, 0);
+        forkJoinFor(pool, pieces, [&](size_t i) { starts[i + 1] = countTokens(piece(i)); });
+        for (size_t i = 0; i < pieces; i++) {
+            starts[i + 1] += starts[i];
+        }
+        if (starts[pieces] > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+        count = starts[pieces];
+        nodes.reset(new PostfixNode[count]);
+        std::vector<char> valid(pieces, 0);
+        forkJoinFor(pool, pieces, [&](size_t i) { valid[i] = tokenize(piece(i), nodes.get() + starts[i]); });
+        if (std::find(valid.begin(), valid.end(), 0) != valid.end()) {
+            return false;
+        }
+
+        // Размеры поддеревьев: в стеке - корни готовых поддеревьев
+        std::vector<uint32_t> roots;
+        for (size_t i = 0; i < count; i++) {
+            size_t start = i;
+            if (nodes[i].op == OPERATOR_NOT) {
+                if (roots.empty()) return false;
+                start = subtreeStart(roots.back());
+                roots.pop_back();
+            } else if (nodes[i].op != 0) {
+                if (roots.size() < 2) return false;
+                roots.pop_back();
+                start = subtreeStart(roots.back());
+                roots.pop_back();
+            }
+            nodes[i].size = static_cast<uint32_t>(i + 1 - start);
+            roots.push_back(static_cast<uint32_t>(i));
+        }
+        return roots.size() == 1;
+    }
+
+    // Узлов в дереве
+    size_t size() const {
+        return count;
+    }
+
+    // Вычисление разобранного выражения; ошибка та же и на том же месте,
+    // что и у tryEvaluatePostfix
+    template <class Number>
+    EvaluationResult<Number> evaluate(WorkStealingPool& pool, size_t cutoff = FORK_JOIN_CUTOFF) const {
+        SubtreeResult<Number> result;
+        std::atomic<bool> done(false);
+        // Корень вычисляется задачей пула, текущий поток помогает
+        pool.submit([&]() {
+            result = evaluateSubtree<Number>(count - 1, pool, cutoff);
+            done.store(true, std::memory_order_release);
+        });
+        forkJoinWait(pool, done);
+        if (result.ok()) {
+            return std::move(result.value);
+        }
+        // Место ошибки: токен с номером узла
+        Tokenizer tokenizer(text);
+        std::string_view token;
+        for (size_t i = 0; i <= result.errorNode; i++) {
+            tokenizer.next(token);
+        }
+        return evaluationError(result.code, text, token);
+    }
+};
+
+#endif
@@ -0,0 +1,145 @@
+// Дифференциальная проверка параллельного вычисления (forkjoin.h): случайные
+// выражения вычисляются деревом PostfixTree с разными порогами
+// последовательного вычисления и tryEvaluatePostfix, результаты и ошибки
+// (причина и смещение) должны совпасть. Маленькие пороги дробят дерево на
+// задачи почти по узлу, поэтому ошибки из разных поддеревьев гонятся друг с
+// другом. Часть операций заменяется на /, %, сдвиги и битовые, добавляются НЕ
+// и неверные токены (такое выражение вычисляется обычным способом).
+// Сборка: g++ -O2 -std=c++17 -pthread forkjoincheck.cpp -o forkjoincheck
+// Запуск: forkjoincheck [--count C] [--tokens N] [--seed S] [--threads T]
+#define POSTFIX_NO_MAIN
+#include "2.cpp"
+#undef POSTFIX_NO_MAIN
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "generator.h"
+
+// Итоги проверки одного типа чисел
+struct ForkJoinCheckResult {
+    size_t expressions = 0; // Проверено выражений
+    size_t errors = 0; // Выражений, закончившихся ошибкой
+    size_t unparsed = 0; // Выражений, не разобранных в дерево
+    size_t mismatches = 0; // Расхождений с tryEvaluatePostfix
+};
+
+// Пороги последовательного вычисления поддерева
+const size_t FORK_JOIN_CHECK_CUTOFFS[] = {1, 3, 17};
+
+// Выражение генератора с заменой части операций и вставками НЕ (в среднем
+// по одной на 64 токена, чтобы длинные выражения не всегда давали ошибку);
+// изредка - неверный токен или лишний операнд
+std::string mutate(const std::string& expression, SplitMix64& random) {
+    static const char* const OPERATORS[] = {"/", "%", "&", "|", "^", "<<", ">>", ">>>"};
+    std::string text;
+    Tokenizer tokenizer(expression);
+    std::string_view token;
+    while (tokenizer.next(token)) {
+        if (!text.empty()) {
+            text += ' ';
+        }
+        if (binaryOperatorCode(token) != 0 && random.below(32) == 0) {
+            text += OPERATORS[random.below(8)];
+        } else {
+            text.append(token.data(), token.size());
+        }
+        if (random.below(64) == 0) {
+            text += " ~";
+        }
+    }
+    if (random.below(20) == 0) {
+        text.insert(random.below(text.size() + 1), random.below(2) ? " x " : " 1 ");
+    }
+    return text;
+}
+
+template <class Number>
+ForkJoinCheckResult checkForkJoin(const GeneratorOptions& options, size_t count, WorkStealingPool& pool) {
+    ForkJoinCheckResult result;
+    ExpressionGenerator generator(options);
+    SplitMix64 random(options.seed * 31 + 7);
+    std::string expression;
+    for (size_t i = 0; i < count; i++) {
+        generator.generate(expression);
+        std::string text = mutate(expression, random);
+        std::string expected = outcome(tryEvaluatePostfix<Number>(text));
+
+        std::vector<std::string> actual;
+        PostfixTree tree;
+        if (tree.parse(text, pool)) {
+            for (size_t cutoff : FORK_JOIN_CHECK_CUTOFFS) {
+                actual.push_back(outcome(tree.evaluate<Number>(pool, cutoff)));
+            }
+        } else {
+            result.unparsed++;
+        }
+        actual.push_back(outcome(tryEvaluateForkJoin<Number>(text, pool)));
+
+        for (const std::string& value : actual) {
+            if (value != expected) {
+                if (result.mismatches < 5) {
+                    std::cerr << "Mismatch: " << text.substr(0, 200) << "\n  expected " << expected << "\n  fork-join "
+                              << value << std::endl;
+                }
+                result.mismatches++;
+                break;
+            }
+        }
+        result.errors += expected.compare(0, 6, "error ") == 0 ? 1 : 0;
+        result.expressions++;
+    }
+    return result;
+}
+
+void printForkJoinCheck(const char* name, const ForkJoinCheckResult& result) {
+    std::cout << std::left << std::setw(12) << name << std::right << result.expressions << " expressions, "
+              << result.errors << " errors, " << result.unparsed << " unparsed, " << result.mismatches << " mismatches"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        GeneratorOptions options;
+        options.tokens = 301;
+        size_t count = 2000;
+        unsigned threads = 0;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--count" && hasValue) count = std::stoull(argv[++i]);
+            else if (arg == "--tokens" && hasValue) options.tokens = std::stoull(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+            else if (arg == "--threads" && hasValue) threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            else throw std::runtime_error("Unknown argument: " + arg);
+        }
+        WorkStealingPool pool(threads);
+
+        // Короткие выражения: 8 бит без переполнения хотя бы в части выражений
+        GeneratorOptions compact = options;
+        compact.tokens = 31;
+        // Глубокие деревья: длинные цепочки операций
+        GeneratorOptions deep = options;
+        deep.maxDepth = 64;
+        // Большие литералы: переполнение 8 бит в большинстве поддеревьев
+        GeneratorOptions large = options;
+        large.maxValue = 127;
+
+        size_t mismatches = 0;
+        auto run = [&](const char* name, const ForkJoinCheckResult& result) {
+            printForkJoinCheck(name, result);
+            mismatches += result.mismatches;
+        };
+        run("8 throw", checkForkJoin<Binary<8, OVERFLOW_THROW>>(compact, count, pool));
+        run("8 throw big", checkForkJoin<Binary<8, OVERFLOW_THROW>>(large, count, pool));
+        run("8 wrap", checkForkJoin<Binary<8, OVERFLOW_WRAP>>(deep, count, pool));
+        run("32", checkForkJoin<Binary32>(deep, count, pool));
+        run("big", checkForkJoin<BigBinary>(large, count, pool));
+        return mismatches == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
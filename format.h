@@ -0,0 +1,204 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "bigbinary.h"
+#include "binary.h"
+
+// Вид вывода результата
+enum FormatMode {
+    FORMAT_BINARY, // Биты и десятичное число, как operator<<: "00000101 (5)"
+    FORMAT_HEX, // Шестнадцатеричное слово и десятичное число: "0x05 (5)"
+    FORMAT_DECIMAL // Только десятичное число: "5"
+};
+
+// Вид вывода по имени ключа --format
+inline FormatMode parseFormatMode(const std::string& name) {
+    if (name == "binary") return FORMAT_BINARY;
+    if (name == "hex") return FORMAT_HEX;
+    if (name == "decimal") return FORMAT_DECIMAL;
+    throw std::runtime_error("Unknown format: " + name);
+}
+
+// Таблицы для вывода по байту и по паре десятичных цифр (строятся при компиляции)
+struct FormatTables {
+    char binary[256][8]; // Биты байта, старший первый
+    char hex[256][2]; // Две шестнадцатеричные цифры байта
+    char digits[100][2]; // Две десятичные цифры числа 0..99
+
+    constexpr FormatTables() : binary(), hex(), digits() {
+        const char* HEX_DIGITS = "0123456789abcdef";
+        for (int byte = 0; byte < 256; byte++) {
+            for (int bit = 0; bit < 8; bit++) {
+                binary[byte][bit] = static_cast<char>('0' + ((byte >> (7 - bit)) & 1));
+            }
+            hex[byte][0] = HEX_DIGITS[byte >> 4];
+            hex[byte][1] = HEX_DIGITS[byte & 0xf];
+        }
+        for (int i = 0; i < 100; i++) {
+            digits[i][0] = static_cast<char>('0' + i / 10);
+            digits[i][1] = static_cast<char>('0' + i % 10);
+        }
+    }
+};
+
+inline constexpr FormatTables FORMAT_TABLES{};
+
+// Наибольшая длина одного результата Binary (64 бита, десятичное число и пометка переполнения)
+const size_t FORMAT_BUFFER_BYTES = 128;
+
+// Запись десятичного числа по две цифры за шаг; возвращает длину
+inline size_t formatDecimal(char* out, long long value) {
+    char text[24];
+    char* end = text + sizeof(text);
+    char* p = end;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+    while (magnitude >= 100) {
+        p -= 2;
+        std::memcpy(p, FORMAT_TABLES.digits[magnitude % 100], 2);
+        magnitude /= 100;
+    }
+    if (magnitude >= 10) {
+        p -= 2;
+        std::memcpy(p, FORMAT_TABLES.digits[magnitude], 2);
+    } else {
+        *--p = static_cast<char>('0' + magnitude);
+    }
+    if (value < 0) {
+        *--p = '-';
+    }
+    size_t length = static_cast<size_t>(end - p);
+    std::memcpy(out, p, length);
+    return length;
+}
+
+// Запись Binary в буфер вызывающего (не меньше FORMAT_BUFFER_BYTES байт)
+// без потоков ввода-вывода; возвращает длину. В режиме FORMAT_BINARY
+// результат совпадает с operator<<.
+template <int N, OverflowPolicy POLICY>
+size_t formatNumber(char* out, const Binary<N, POLICY>& value, FormatMode mode) {
+    static_assert(N % 8 == 0, "formatNumber needs whole bytes");
+    char* p = out;
+    uint64_t word = static_cast<uint64_t>(value.word());
+    if (mode == FORMAT_BINARY) {
+        for (int shift = N - 8; shift >= 0; shift -= 8) {
+            std::memcpy(p, FORMAT_TABLES.binary[(word >> shift) & 0xff], 8);
+            p += 8;
+        }
+    } else if (mode == FORMAT_HEX) {
+        *p++ = '0';
+        *p++ = 'x';
+        for (int shift = N - 8; shift >= 0; shift -= 8) {
+            std::memcpy(p, FORMAT_TABLES.hex[(word >> shift) & 0xff], 2);
+            p += 2;
+        }
+    }
+    if (mode != FORMAT_DECIMAL) {
+        *p++ = ' ';
+        *p++ = '(';
+    }
+    p += formatDecimal(p, value.decimal());
+    if (mode != FORMAT_DECIMAL) {
+        *p++ = ')';
+    }
+    if (value.overflowed()) {
+        std::memcpy(p, " [overflow]", 11);
+        p += 11;
+    }
+    return static_cast<size_t>(p - out);
+}
+
+// Добавление результата к строке
+template <int N, OverflowPolicy POLICY>
+void appendNumber(std::string& out, const Binary<N, POLICY>& value, FormatMode mode) {
+    char text[FORMAT_BUFFER_BYTES];
+    out.append(text, formatNumber(text, value, mode));
+}
+
+// Для BigBinary длина не ограничена, таблицы не используются
+inline void appendNumber(std::string& out, const BigBinary& value, FormatMode mode) {
+    if (mode == FORMAT_DECIMAL) {
+        out += value.decimal();
+    } else if (mode == FORMAT_HEX) {
+        out += value.hex();
+        out += " (";
+        out += value.decimal();
+        out += ')';
+    } else {
+        thread_local std::ostringstream text;
+        text.str(std::string());
+        text << value;
+        out += text.str();
+    }
+}
+
+// Объем буфера вывода, после которого он сбрасывается
+const size_t OUTPUT_BUFFER_BYTES = 1 << 20;
+
+// Буфер вывода результатов пакетной обработки. Строки результатов
+// копятся в одной строке и уходят в поток одним вызовом write, когда
+// набирается OUTPUT_BUFFER_BYTES. Без потока буфер только копит текст
+// (например, вывод куска при многопоточной обработке).
+class OutputBuffer {
+    std::ostream* sink; // Поток вывода или nullptr
+    FormatMode mode; // Вид вывода чисел
+    std::string text; // Накопленный вывод
+
+public:
+    OutputBuffer(std::ostream& out, FormatMode _mode) : sink(&out), mode(_mode) {
+        text.reserve(OUTPUT_BUFFER_BYTES + FORMAT_BUFFER_BYTES);
+    }
+
+    explicit OutputBuffer(FormatMode _mode) : sink(nullptr), mode(_mode) {}
+
+    ~OutputBuffer() {
+        flush();
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    // Строка результата
+    template <class Number>
+    void appendResult(const Number& value) {
+        appendNumber(text, value, mode);
+        text += '\n';
+        flushIfFull();
+    }
+
+    // Строка "Error: сообщение"
+    void appendError(std::string_view message) {
+        text += "Error: ";
+        text.append(message.data(), message.size());
+        text += '\n';
+        flushIfFull();
+    }
+
+    void flushIfFull() {
+        if (sink != nullptr && text.size() >= OUTPUT_BUFFER_BYTES) {
+            flush();
+        }
+    }
+
+    // Запись накопленного текста в поток (сам поток не сбрасывается)
+    void flush() {
+        if (sink != nullptr && !text.empty()) {
+            sink->write(text.data(), static_cast<std::streamsize>(text.size()));
+            text.clear();
+        }
+    }
+
+    // Накопленный текст (для буфера без потока)
+    std::string& str() {
+        return text;
+    }
+};
+
+#endif
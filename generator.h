@@ -0,0 +1,117 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Параметры генератора постфиксных выражений
+struct GeneratorOptions {
+    size_t tokens = 15; // Токенов в выражении (четное число уменьшается на 1)
+    size_t maxDepth = 16; // Наибольшая глубина стека операндов (не меньше 2)
+    unsigned addWeight = 1; // Относительная частота '+'
+    unsigned subWeight = 1; // Относительная частота '-'
+    unsigned mulWeight = 1; // Относительная частота '*'
+    int maxValue = 9; // Литералы берутся из диапазона [0, maxValue]
+    uint64_t seed = 1; // Начальное состояние генератора
+};
+
+// Генератор псевдослучайных чисел splitmix64: при одном и том же начальном
+// состоянии на любой платформе получается одна и та же последовательность
+class SplitMix64 {
+    uint64_t state; // Состояние
+
+public:
+    explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+    // Следующее псевдослучайное число
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Случайное число из диапазона [0, bound)
+    size_t below(size_t bound) {
+        return static_cast<size_t>(next() % bound);
+    }
+};
+
+// Детерминированный генератор корректных постфиксных выражений:
+// при одних и тех же параметрах на любой платформе получаются одни и те же
+// выражения. На каждом шаге, когда возможны и операнд, и операция,
+// выбор делается случайно; глубина стека не превышает maxDepth.
+class ExpressionGenerator {
+    GeneratorOptions options; // Параметры
+    SplitMix64 random; // Источник случайных чисел
+
+    // Случайная операция с учетом частот
+    char nextOperator() {
+        unsigned total = options.addWeight + options.subWeight + options.mulWeight;
+        if (total == 0) {
+            return '+';
+        }
+        uint64_t r = random.next() % total;
+        if (r < options.addWeight) return '+';
+        if (r < options.addWeight + options.subWeight) return '-';
+        return '*';
+    }
+
+public:
+    explicit ExpressionGenerator(const GeneratorOptions& _options) : options(_options), random(_options.seed) {
+        if (options.tokens % 2 == 0) {
+            options.tokens = options.tokens > 0 ? options.tokens - 1 : 1;
+        }
+        if (options.maxDepth < 2) {
+            options.maxDepth = 2;
+        }
+        if (options.maxValue < 0) {
+            options.maxValue = 0;
+        }
+    }
+
+    // Очередное выражение в text (содержимое text заменяется)
+    void generate(std::string& text) {
+        text.clear();
+        size_t operands = (options.tokens + 1) / 2; // Осталось положить операндов
+        size_t depth = 0; // Текущая глубина стека
+        uint64_t range = static_cast<uint64_t>(options.maxValue) + 1;
+
+        while (operands > 0 || depth > 1) {
+            bool push;
+            if (depth < 2) push = true;
+            else if (operands == 0 || depth >= options.maxDepth) push = false;
+            else push = (random.next() & 1) != 0;
+
+            if (!text.empty()) {
+                text += ' ';
+            }
+            if (push) {
+                char digits[16];
+                long long value = static_cast<long long>(random.next() % range);
+                char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+                text.append(digits, end);
+                operands--;
+                depth++;
+            } else {
+                text += nextOperator();
+                depth--;
+            }
+        }
+    }
+};
+
+// Перцентиль отсортированных задержек (для отчетов bench.cpp и client.cpp)
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef INFIX_H
+#define INFIX_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "instrument.h"
+#include "operand_stack.h"
+#include "operators.h"
+#include "tokenizer.h"
+
+// Унарный минус в стеке операций (отличается от бинарного '-')
+const char INFIX_NEGATE = 'n';
+
+// Приоритет операции с кодом из operators.h (0 - не операция), как в C++.
+// Все бинарные операции левоассоциативны, унарные минус и НЕ - префиксные.
+inline int infixPrecedence(char op) {
+    switch (op) {
+        case '|':
+            return 1;
+        case '^':
+            return 2;
+        case '&':
+            return 3;
+        case OPERATOR_SHIFT_LEFT:
+        case OPERATOR_SHIFT_RIGHT:
+        case OPERATOR_LOGICAL_SHIFT_RIGHT:
+            return 4;
+        case '+':
+        case '-':
+            return 5;
+        case '*':
+        case '/':
+        case '%':
+            return 6;
+        case INFIX_NEGATE:
+        case OPERATOR_NOT:
+            return 7;
+        default:
+            return 0;
+    }
+}
+
+// Бинарная операция в начале text: код операции и длина ее записи
+// (0 - не операция). Из сдвигов выбирается самая длинная запись.
+inline char infixBinaryOperator(std::string_view text, size_t& length) {
+    for (length = 3; length > 0; length--) {
+        if (length <= text.size()) {
+            char op = binaryOperatorCode(text.substr(0, length));
+            if (op != 0) {
+                return op;
+            }
+        }
+    }
+    return 0;
+}
+
+// Применение операции к вершине стека операндов
+template <class Number>
+void applyInfixOperator(char op, OperandStack<Number>& operands) {
+    if (op == INFIX_NEGATE || op == OPERATOR_NOT) {
+        if (operands.isEmpty()) throw std::runtime_error("Invalid expression");
+        Number a = operands.pop();
+        operands.push(op == INFIX_NEGATE ? -a : ~a);
+        return;
+    }
+
+    if (operands.size() < 2) throw std::runtime_error("Invalid expression");
+    Number b = operands.pop();
+    Number a = operands.pop();
+
+    operands.push(applyBinaryOperator(op, a, b));
+}
+
+// Вычисление инфиксного выражения за один проход (алгоритм сортировочной
+// станции): операнды сразу кладутся в стек операндов, а операция из стека
+// операций применяется к ним, как только становится ясно, что ее приоритет
+// не ниже следующей. Постфиксная строка и список токенов не строятся.
+// Поддерживаются операции из operators.h, скобки, унарный минус и ~;
+// пробелы между токенами не обязательны. Минус прямо перед цифрой - знак литерала.
+template <class Number>
+Number evaluateInfix(std::string_view expression) {
+    INSTRUMENT_PHASE(evaluateNanos);
+    thread_local OperandStack<Number> operands; // Стек операндов потока
+    thread_local OperandStack<char> operators; // Стек операций и открывающих скобок
+    operands.clear();
+    operators.clear();
+
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+    auto isDelimiter = [](char c) {
+        size_t length;
+        return isSpace(c) || c == '(' || c == ')' || c == OPERATOR_NOT || c == '<' || c == '>' ||
+               infixBinaryOperator(std::string_view(&c, 1), length) != 0;
+    };
+    // Некорректный токен: символы до ближайшего разделителя
+    auto invalidToken = [&](size_t start) {
+        size_t end = start + 1;
+        while (end < expression.size() && !isDelimiter(expression[end])) {
+            end++;
+        }
+        return std::runtime_error("Invalid token: " + std::string(expression.substr(start, end - start)));
+    };
+
+    bool expectOperand = true; // Ожидается операнд (иначе - бинарная операция или ')')
+    size_t i = 0;
+    while (i < expression.size()) {
+        char c = expression[i];
+        if (isSpace(c)) {
+            i++;
+            continue;
+        }
+
+        if (expectOperand) {
+            if (c == '(') {
+                operators.push('(');
+                i++;
+            } else if (isDigit(c) || (c == '-' && i + 1 < expression.size() && isDigit(expression[i + 1]))) {
+                size_t start = i++;
+                while (i < expression.size() && isDigit(expression[i])) {
+                    i++;
+                }
+                int value;
+                if (!parseInt(expression.substr(start, i - start), value)) {
+                    throw std::runtime_error("Invalid token: " + std::string(expression.substr(start, i - start)));
+                }
+                operands.push(Number(value));
+                expectOperand = false;
+            } else if (c == '-') {
+                operators.push(INFIX_NEGATE);
+                i++;
+            } else if (c == OPERATOR_NOT) {
+                operators.push(OPERATOR_NOT);
+                i++;
+            } else if (isDelimiter(c)) {
+                throw std::runtime_error("Invalid expression");
+            } else {
+                throw invalidToken(i);
+            }
+            continue;
+        }
+
+        size_t length;
+        char op = infixBinaryOperator(expression.substr(i), length);
+        if (c == ')') {
+            // Применение операций до открывающей скобки
+            while (!operators.isEmpty() && operators.top() != '(') {
+                applyInfixOperator(operators.pop(), operands);
+            }
+            if (operators.isEmpty()) throw std::runtime_error("Invalid expression");
+            operators.pop();
+            i++;
+        } else if (op != 0) {
+            // Применение операций с приоритетом не ниже текущей (левая ассоциативность)
+            while (!operators.isEmpty() && operators.top() != '(' && infixPrecedence(operators.top()) >= infixPrecedence(op)) {
+                applyInfixOperator(operators.pop(), operands);
+            }
+            operators.push(op);
+            expectOperand = true;
+            i += length;
+        } else if (c == '(' || isDigit(c) || c == OPERATOR_NOT) {
+            // Два операнда подряд без операции между ними
+            throw std::runtime_error("Invalid expression");
+        } else {
+            throw invalidToken(i);
+        }
+    }
+
+    if (expectOperand) throw std::runtime_error("Invalid expression");
+
+    while (!operators.isEmpty()) {
+        char op = operators.pop();
+        if (op == '(') throw std::runtime_error("Invalid expression");
+        applyInfixOperator(op, operands);
+    }
+
+    Number result = operands.pop();
+
+    if (!operands.isEmpty()) throw std::runtime_error("Invalid expression");
+
+    return result;
+}
+
+#endif
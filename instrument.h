@@ -0,0 +1,194 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <ostream>
+
+// Необязательные счетчики производительности. Включаются при сборке с
+// -DPOSTFIX_INSTRUMENT; без этого макросы INSTRUMENT_* раскрываются в пустые
+// выражения и ничего не стоят.
+//
+// INSTRUMENT_COUNT(поле) - увеличить счетчик текущего потока на 1 (можно в constexpr-функциях),
+// INSTRUMENT_PHASE(поле) - добавить к счетчику время (нс) до конца блока.
+// Отчет в формате JSON пишется вызовом writeInstrumentReport() и при выходе
+// из программы - в файл из переменной окружения INSTRUMENT_REPORT или в stderr.
+
+#ifdef POSTFIX_INSTRUMENT
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// Счетчики одного потока. Пишет только свой поток, поэтому увеличение -
+// обычные load/store без блокировки шины; атомарность нужна только для
+// чтения отчета из другого потока.
+struct InstrumentCounters {
+    std::atomic<uint64_t> tokens{0}; // Прочитано токенов
+    std::atomic<uint64_t> pushAllocations{0}; // Выделений памяти при push в стек операндов
+    std::atomic<uint64_t> binaryConstructions{0}; // Созданий Binary (по умолчанию, из числа, из слова)
+    std::atomic<uint64_t> additions{0}; // Вызовов Binary::operator+ (operator* его не вызывает)
+    std::atomic<uint64_t> multiplications{0}; // Вызовов Binary::operator* (одно машинное умножение)
+    std::atomic<uint64_t> tokenizeNanos{0}; // Время разбора токенов и чисел, нс
+    std::atomic<uint64_t> evaluateNanos{0}; // Время вычисления выражений целиком, нс
+};
+
+typedef std::atomic<uint64_t> InstrumentCounters::*InstrumentField;
+
+// Увеличение счетчика своего потока
+inline void instrumentAdd(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Сумма счетчиков
+struct InstrumentTotals {
+    uint64_t tokens = 0;
+    uint64_t pushAllocations = 0;
+    uint64_t binaryConstructions = 0;
+    uint64_t additions = 0;
+    uint64_t multiplications = 0;
+    uint64_t tokenizeNanos = 0;
+    uint64_t evaluateNanos = 0;
+
+    void add(const InstrumentCounters& counters) {
+        tokens += counters.tokens.load(std::memory_order_relaxed);
+        pushAllocations += counters.pushAllocations.load(std::memory_order_relaxed);
+        binaryConstructions += counters.binaryConstructions.load(std::memory_order_relaxed);
+        additions += counters.additions.load(std::memory_order_relaxed);
+        multiplications += counters.multiplications.load(std::memory_order_relaxed);
+        tokenizeNanos += counters.tokenizeNanos.load(std::memory_order_relaxed);
+        evaluateNanos += counters.evaluateNanos.load(std::memory_order_relaxed);
+    }
+};
+
+// Реестр счетчиков всех потоков. Счетчики завершившихся потоков
+// прибавляются к retired, поэтому отчет учитывает и их.
+class InstrumentRegistry {
+    std::mutex mutex;
+    std::vector<InstrumentCounters*> live; // Счетчики работающих потоков
+    InstrumentTotals retired; // Сумма счетчиков завершившихся потоков
+    size_t threads = 0; // Всего потоков, которые что-то считали
+
+    static void writeTotals(std::ostream& os, const InstrumentTotals& totals) {
+        const double seconds = 1e-9; // Секунд в наносекунде
+        os << "{\"tokens\": " << totals.tokens
+           << ", \"push_allocations\": " << totals.pushAllocations
+           << ", \"binary_constructions\": " << totals.binaryConstructions
+           << ", \"additions\": " << totals.additions
+           << ", \"multiplications\": " << totals.multiplications
+           << ", \"tokenize_seconds\": " << static_cast<double>(totals.tokenizeNanos) * seconds
+           << ", \"compute_seconds\": "
+           << static_cast<double>(totals.evaluateNanos > totals.tokenizeNanos ? totals.evaluateNanos - totals.tokenizeNanos : 0) * seconds
+           << ", \"evaluate_seconds\": " << static_cast<double>(totals.evaluateNanos) * seconds << "}";
+    }
+
+public:
+    InstrumentRegistry() = default;
+    InstrumentRegistry(const InstrumentRegistry&) = delete;
+    InstrumentRegistry& operator=(const InstrumentRegistry&) = delete;
+
+    // Отчет при выходе из программы
+    ~InstrumentRegistry() {
+        const char* path = std::getenv("INSTRUMENT_REPORT");
+        if (path != nullptr && *path != '\0') {
+            std::ofstream file(path);
+            write(file);
+        } else {
+            write(std::cerr);
+        }
+    }
+
+    void attach(InstrumentCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        live.push_back(counters);
+        threads++;
+    }
+
+    void detach(InstrumentCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        retired.add(*counters);
+        for (size_t i = 0; i < live.size(); i++) {
+            if (live[i] == counters) {
+                live[i] = live.back();
+                live.pop_back();
+                break;
+            }
+        }
+    }
+
+    // Отчет: сумма по всем потокам и счетчики работающих потоков
+    void write(std::ostream& os) {
+        std::lock_guard<std::mutex> lock(mutex);
+        InstrumentTotals total = retired;
+        for (InstrumentCounters* counters : live) {
+            total.add(*counters);
+        }
+        os << "{\"enabled\": true, \"threads\": " << threads << ", \"total\": ";
+        writeTotals(os, total);
+        os << ", \"live_threads\": [";
+        for (size_t i = 0; i < live.size(); i++) {
+            InstrumentTotals one;
+            one.add(*live[i]);
+            os << (i ? ", " : "");
+            writeTotals(os, one);
+        }
+        os << "]}" << std::endl;
+    }
+};
+
+inline InstrumentRegistry& instrumentRegistry() {
+    static InstrumentRegistry registry;
+    return registry;
+}
+
+// Счетчики текущего потока (регистрируются при первом обращении)
+inline InstrumentCounters& instrumentLocal() {
+    struct Thread {
+        InstrumentCounters counters;
+        Thread() { instrumentRegistry().attach(&counters); }
+        ~Thread() { instrumentRegistry().detach(&counters); }
+    };
+    thread_local Thread thread;
+    return thread.counters;
+}
+
+// Таймер фазы: время жизни объекта прибавляется к счетчику
+class InstrumentPhase {
+    InstrumentField field;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit InstrumentPhase(InstrumentField _field) : field(_field), start(std::chrono::steady_clock::now()) {}
+
+    ~InstrumentPhase() {
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        instrumentAdd(instrumentLocal().*field, static_cast<uint64_t>(nanos));
+    }
+};
+
+#define INSTRUMENT_JOIN2(a, b) a##b
+#define INSTRUMENT_JOIN(a, b) INSTRUMENT_JOIN2(a, b)
+// При вычислении во время компиляции (constexpr-операции Binary) счетчик не трогается
+#define INSTRUMENT_COUNT(field) (__builtin_is_constant_evaluated() ? (void)0 : instrumentAdd(instrumentLocal().field, 1))
+#define INSTRUMENT_PHASE(field) InstrumentPhase INSTRUMENT_JOIN(instrumentPhase, __LINE__)(&InstrumentCounters::field)
+
+// Отчет по требованию
+inline void writeInstrumentReport(std::ostream& os) {
+    instrumentRegistry().write(os);
+}
+
+#else
+
+#define INSTRUMENT_COUNT(field) ((void)0)
+#define INSTRUMENT_PHASE(field) ((void)0)
+
+inline void writeInstrumentReport(std::ostream& os) {
+    os << "{\"enabled\": false}" << std::endl;
+}
+
+#endif
+
+#endif
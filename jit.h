@@ -0,0 +1,437 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "binary.h"
+#include "bytecode.h"
+#include "tokenizer.h"
+
+// Компиляция байт-кода формулы в машинный код x86-64 (только Linux x86-64;
+// на других платформах и для неподдерживаемых типов чисел вычисляет
+// интерпретатор CompiledExpression).
+//
+// Число из N бит (8, 16 или 32) хранится в 32-битном регистре сдвинутым
+// влево на 32 - N бит, младшие биты нулевые. Тогда обычные 32-битные add,
+// sub и imul дают результат по модулю 2^N в старших битах, а флаг OF
+// выставляется ровно при переполнении N-битного числа: при политике
+// OVERFLOW_THROW после каждой операции стоит jo на выход с ошибкой.
+// Первые JIT_REGISTER_SLOTS ячеек стека живут в регистрах, остальные -
+// в памяти (массив, который передает вызывающий).
+#if defined(__linux__) && defined(__x86_64__)
+#define JIT_AVAILABLE 1
+#include <sys/mman.h>
+#else
+#define JIT_AVAILABLE 0
+#endif
+
+// Машинный код: (значения переменных, ячейки стека в памяти, результат) -> 0 или 1 при переполнении
+typedef int (*JitFunction)(const void* bindings, int32_t* spill, int32_t* result);
+
+// Исполняемый буфер: код копируется в отображенную память, которая затем
+// становится доступной только для чтения и выполнения
+class JitCode {
+    void* memory; // Начало отображения (nullptr - кода нет)
+    size_t length; // Размер отображения
+
+public:
+    JitCode() : memory(nullptr), length(0) {}
+
+    explicit JitCode(const std::vector<uint8_t>& bytes) : memory(nullptr), length(0) {
+#if JIT_AVAILABLE
+        void* region = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED) {
+            return;
+        }
+        std::memcpy(region, bytes.data(), bytes.size());
+        if (mprotect(region, bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+            munmap(region, bytes.size());
+            return;
+        }
+        memory = region;
+        length = bytes.size();
+#else
+        (void)bytes;
+#endif
+    }
+
+    ~JitCode() {
+#if JIT_AVAILABLE
+        if (memory != nullptr) {
+            munmap(memory, length);
+        }
+#endif
+    }
+
+    JitCode(const JitCode&) = delete;
+    JitCode& operator=(const JitCode&) = delete;
+
+    // Точка входа (nullptr, если код не создан)
+    JitFunction function() const {
+        return reinterpret_cast<JitFunction>(memory);
+    }
+};
+
+// Ассемблер нужного подмножества x86-64 (32-битные операции над регистрами)
+class X64Assembler {
+public:
+    // Номера регистров
+    enum Register { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+private:
+    std::vector<uint8_t> bytes;
+
+    void byte(int value) {
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    void dword(uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            byte(static_cast<int>(value >> (8 * i) & 0xff));
+        }
+    }
+
+    // Префикс REX для регистров r8-r15 (reg - поле reg, rm - поле r/m)
+    void rex(int reg, int rm) {
+        int prefix = 0x40 | (reg >> 3) << 2 | (rm >> 3);
+        if (prefix != 0x40) {
+            byte(prefix);
+        }
+    }
+
+    void modrm(int mod, int reg, int rm) {
+        byte(mod << 6 | (reg & 7) << 3 | (rm & 7));
+    }
+
+public:
+    const std::vector<uint8_t>& code() const {
+        return bytes;
+    }
+
+    size_t position() const {
+        return bytes.size();
+    }
+
+    // mov dst, imm32
+    void movImmediate(int dst, uint32_t value) {
+        rex(0, dst);
+        byte(0xB8 + (dst & 7));
+        dword(value);
+    }
+
+    // mov dst, src
+    void mov(int dst, int src) {
+        rex(src, dst);
+        byte(0x89);
+        modrm(3, src, dst);
+    }
+
+    // add dst, src
+    void add(int dst, int src) {
+        rex(src, dst);
+        byte(0x01);
+        modrm(3, src, dst);
+    }
+
+    // sub dst, src
+    void sub(int dst, int src) {
+        rex(src, dst);
+        byte(0x29);
+        modrm(3, src, dst);
+    }
+
+    // imul dst, src
+    void imul(int dst, int src) {
+        rex(dst, src);
+        byte(0x0F);
+        byte(0xAF);
+        modrm(3, dst, src);
+    }
+
+    // shl dst, count
+    void shl(int dst, int count) {
+        rex(0, dst);
+        byte(0xC1);
+        modrm(3, 4, dst);
+        byte(count);
+    }
+
+    // sar dst, count
+    void sar(int dst, int count) {
+        rex(0, dst);
+        byte(0xC1);
+        modrm(3, 7, dst);
+        byte(count);
+    }
+
+    // xor dst, src
+    void xorRegisters(int dst, int src) {
+        rex(src, dst);
+        byte(0x31);
+        modrm(3, src, dst);
+    }
+
+    // Загрузка с расширением нулями: movzx dst, byte/word [base + offset] или mov dst, dword [...]
+    void load(int dst, int base, int32_t offset, int size) {
+        rex(dst, base);
+        if (size == 1) {
+            byte(0x0F);
+            byte(0xB6);
+        } else if (size == 2) {
+            byte(0x0F);
+            byte(0xB7);
+        } else {
+            byte(0x8B);
+        }
+        modrm(2, dst, base);
+        dword(static_cast<uint32_t>(offset));
+    }
+
+    // mov dword [base + offset], src
+    void store(int base, int32_t offset, int src) {
+        rex(src, base);
+        byte(0x89);
+        modrm(2, src, base);
+        dword(static_cast<uint32_t>(offset));
+    }
+
+    // jo с пока неизвестным адресом; возвращает место для patch
+    size_t jumpIfOverflow() {
+        byte(0x0F);
+        byte(0x80);
+        dword(0);
+        return bytes.size() - 4;
+    }
+
+    // Направление перехода на текущее место
+    void patch(size_t at) {
+        uint32_t relative = static_cast<uint32_t>(bytes.size() - (at + 4));
+        std::memcpy(&bytes[at], &relative, 4);
+    }
+
+    void push(int reg) {
+        rex(0, reg);
+        byte(0x50 + (reg & 7));
+    }
+
+    void pop(int reg) {
+        rex(0, reg);
+        byte(0x58 + (reg & 7));
+    }
+
+    void ret() {
+        byte(0xC3);
+    }
+};
+
+// Ячеек стека в регистрах
+const size_t JIT_REGISTER_SLOTS = 10;
+
+// Регистры ячеек стека. rdi, rsi, rdx - аргументы, rax и rcx - рабочие
+const int JIT_SLOT_REGISTERS[JIT_REGISTER_SLOTS] = {
+    X64Assembler::R8, X64Assembler::R9, X64Assembler::R10, X64Assembler::R11, X64Assembler::RBX,
+    X64Assembler::RBP, X64Assembler::R12, X64Assembler::R13, X64Assembler::R14, X64Assembler::R15};
+
+// Может ли JIT вычислять числа этого типа
+template <class Number> struct JitSupport {
+    static constexpr bool VALUE = false;
+};
+
+template <int N, OverflowPolicy POLICY> struct JitSupport<Binary<N, POLICY>> {
+    static constexpr bool VALUE = JIT_AVAILABLE && (N == 8 || N == 16 || N == 32) &&
+                                  (POLICY == OVERFLOW_WRAP || POLICY == OVERFLOW_THROW) &&
+                                  sizeof(Binary<N, POLICY>) == N / 8;
+};
+
+// Генерация машинного кода для байт-кода выражения над Binary<N, POLICY>
+template <int N, OverflowPolicy POLICY>
+std::vector<uint8_t> generateJitCode(const CompiledExpression<Binary<N, POLICY>>& expression) {
+    typedef X64Assembler A;
+    const int SHIFT = 32 - N;
+    const size_t depth = expression.maxDepth();
+    const size_t used = std::min(depth, JIT_REGISTER_SLOTS);
+    A a;
+
+    // Сохранение регистров, которые функция обязана вернуть (rbx, rbp, r12-r15)
+    std::vector<int> saved;
+    for (size_t k = 0; k < used; k++) {
+        int reg = JIT_SLOT_REGISTERS[k];
+        if (reg == A::RBX || reg == A::RBP || reg >= A::R12) {
+            saved.push_back(reg);
+            a.push(reg);
+        }
+    }
+
+    // Ячейка стека: регистр или -1 (тогда она в памяти по адресу rsi + 4 * k)
+    auto slotRegister = [&](size_t k) { return k < JIT_REGISTER_SLOTS ? JIT_SLOT_REGISTERS[k] : -1; };
+    auto spillOffset = [](size_t k) { return static_cast<int32_t>(4 * k); };
+    // Регистр со значением ячейки (ячейка из памяти загружается в scratch)
+    auto read = [&](size_t k, int scratch) {
+        int reg = slotRegister(k);
+        if (reg >= 0) {
+            return reg;
+        }
+        a.load(scratch, A::RSI, spillOffset(k), 4);
+        return scratch;
+    };
+
+    std::vector<size_t> overflowJumps;
+    const std::vector<Binary<N, POLICY>>& constants = expression.constantPool();
+    size_t size = 0;
+    for (const Instruction& instruction : expression.instructions()) {
+        if (instruction.op == OP_CONST || instruction.op == OP_VAR) {
+            int reg = slotRegister(size);
+            int target = reg >= 0 ? reg : A::RAX;
+            if (instruction.op == OP_CONST) {
+                uint32_t word = static_cast<uint32_t>(constants[instruction.operand].word());
+                a.movImmediate(target, word << SHIFT);
+            } else {
+                a.load(target, A::RDI, static_cast<int32_t>(instruction.operand * (N / 8)), N / 8);
+                if (SHIFT != 0) {
+                    a.shl(target, SHIFT);
+                }
+            }
+            if (reg < 0) {
+                a.store(A::RSI, spillOffset(size), A::RAX);
+            }
+            size++;
+            continue;
+        }
+
+        size_t left = size - 2, right = size - 1;
+        int dst = read(left, A::RAX);
+        int src = read(right, A::RCX);
+        if (instruction.op == OP_ADD) {
+            a.add(dst, src);
+        } else if (instruction.op == OP_SUB) {
+            a.sub(dst, src);
+        } else if (SHIFT != 0) {
+            // Один множитель возвращается к обычному виду, тогда произведение
+            // получается сразу сдвинутым
+            if (src != A::RCX) {
+                a.mov(A::RCX, src);
+            }
+            a.sar(A::RCX, SHIFT);
+            a.imul(dst, A::RCX);
+        } else {
+            a.imul(dst, src);
+        }
+        if (POLICY == OVERFLOW_THROW) {
+            overflowJumps.push_back(a.jumpIfOverflow());
+        }
+        if (slotRegister(left) < 0) {
+            a.store(A::RSI, spillOffset(left), dst);
+        }
+        size--;
+    }
+
+    // Результат: обратный сдвиг с расширением знака и запись в *rdx
+    int result = read(0, A::RAX);
+    if (result != A::RAX) {
+        a.mov(A::RAX, result);
+    }
+    if (SHIFT != 0) {
+        a.sar(A::RAX, SHIFT);
+    }
+    a.store(A::RDX, 0, A::RAX);
+    a.xorRegisters(A::RAX, A::RAX);
+    auto epilogue = [&]() {
+        for (size_t i = saved.size(); i-- > 0;) {
+            a.pop(saved[i]);
+        }
+        a.ret();
+    };
+    epilogue();
+
+    if (!overflowJumps.empty()) {
+        for (size_t at : overflowJumps) {
+            a.patch(at);
+        }
+        a.movImmediate(A::RAX, 1);
+        epilogue();
+    }
+    return a.code();
+}
+
+// Формула, скомпилированная в машинный код. Если JIT недоступен (другая
+// платформа, неподдерживаемый тип числа или не удалось выделить память),
+// вычисляет интерпретатор байт-кода; результат и ошибки в обоих случаях те же.
+// Копии разделяют один исполняемый буфер.
+template <class Number>
+class JitExpression {
+    CompiledExpression<Number> expression; // Байт-код (для интерпретатора и размеров)
+    std::shared_ptr<const JitCode> code; // Машинный код или nullptr
+
+public:
+    explicit JitExpression(CompiledExpression<Number> _expression) : expression(std::move(_expression)) {
+        if constexpr (JitSupport<Number>::VALUE) {
+            std::shared_ptr<JitCode> compiled = std::make_shared<JitCode>(generateJitCode(expression));
+            if (compiled->function() != nullptr) {
+                code = compiled;
+            }
+        }
+    }
+
+    // Вычисление идет в машинном коде
+    bool isNative() const {
+        return code != nullptr;
+    }
+
+    const CompiledExpression<Number>& bytecode() const {
+        return expression;
+    }
+
+    // Вычисление при заданных значениях переменных (в порядке variableNames())
+    Number evaluate(const Number* bindings) const {
+        if constexpr (JitSupport<Number>::VALUE) {
+            if (code != nullptr) {
+                thread_local std::vector<int32_t> spill; // Ячейки стека, не поместившиеся в регистры
+                if (spill.size() < expression.maxDepth()) {
+                    spill.resize(expression.maxDepth());
+                }
+                int32_t result;
+                if (code->function()(bindings, spill.data(), &result) != 0) {
+                    throw std::runtime_error("Overflow...");
+                }
+                return Number::fromWord(static_cast<typename Number::Word>(result));
+            }
+        }
+        return expression.evaluate(bindings);
+    }
+};
+
+// Вычислитель формулы для пакетного режима на машинном коде (как FormulaEvaluator)
+template <class Number>
+class JitFormulaEvaluator {
+    JitExpression<Number> formula;
+
+public:
+    explicit JitFormulaEvaluator(CompiledExpression<Number> _formula) : formula(std::move(_formula)) {}
+
+    Number operator()(std::string_view line) const {
+        thread_local std::vector<Number> bindings; // Буфер значений переиспользуется между строками
+        bindings.clear();
+        Tokenizer tokenizer(line);
+        std::string_view token;
+        while (tokenizer.next(token)) {
+            int value;
+            if (!parseInt(token, value)) throw std::runtime_error("Invalid token: " + std::string(token));
+            bindings.push_back(Number(value));
+        }
+        size_t width = formula.bytecode().variableNames().size();
+        if (bindings.size() != width) {
+            throw std::runtime_error("Expected " + std::to_string(width) + " values");
+        }
+        return formula.evaluate(bindings.data());
+    }
+};
+
+#endif
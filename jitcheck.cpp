@@ -0,0 +1,151 @@
+// Дифференциальная проверка JIT (jit.h): случайные выражения вычисляются
+// машинным кодом и evaluatePostfix, результаты и ошибки должны совпасть.
+// Каждое выражение проверяется дважды: с литералами как константами и с
+// литералами, замененными на переменные (значения передаются при вычислении).
+// Сборка: g++ -O2 -std=c++17 -pthread jitcheck.cpp -o jitcheck
+// Запуск: jitcheck [--count C] [--tokens N] [--depth D] [--seed S]
+#define POSTFIX_NO_MAIN
+#include "2.cpp"
+#undef POSTFIX_NO_MAIN
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "generator.h"
+#include "jit.h"
+
+// Итоги проверки одного типа чисел
+struct JitCheckResult {
+    size_t expressions = 0; // Проверено выражений
+    size_t errors = 0; // Выражений, закончившихся ошибкой
+    size_t mismatches = 0; // Расхождений с evaluatePostfix
+    double interpreterSeconds = 0; // Время evaluatePostfix
+    double jitSeconds = 0; // Время машинного кода (без компиляции)
+    bool native = true; // Все выражения выполнялись в машинном коде
+};
+
+// Выражение с литералами, замененными на переменные v0, v1, ..., и значения литералов
+template <class Number>
+std::string withVariables(const std::string& expression, std::vector<Number>& values) {
+    std::string text;
+    Tokenizer tokenizer(expression);
+    std::string_view token;
+    int value;
+    values.clear();
+    while (tokenizer.next(token)) {
+        if (!text.empty()) {
+            text += ' ';
+        }
+        if (parseInt(token, value)) {
+            text += "v" + std::to_string(values.size());
+            values.push_back(Number(value));
+        } else {
+            text.append(token.data(), token.size());
+        }
+    }
+    return text;
+}
+
+template <class Number>
+JitCheckResult checkJit(const GeneratorOptions& options, size_t count) {
+    typedef std::chrono::steady_clock Clock;
+    JitCheckResult result;
+    ExpressionGenerator generator(options);
+    std::string expression;
+    std::vector<Number> values;
+    for (size_t i = 0; i < count; i++) {
+        generator.generate(expression);
+        std::string expected, constant, variable;
+
+        Clock::time_point start = Clock::now();
+        try {
+            expected = outcome(evaluatePostfix<Number>(expression));
+        } catch (const std::exception& e) {
+            expected = std::string("Error: ") + e.what();
+            result.errors++;
+        }
+        result.interpreterSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+        JitExpression<Number> constants(CompiledExpression<Number>::compile(expression));
+        JitExpression<Number> variables(CompiledExpression<Number>::compile(withVariables(expression, values)));
+        result.native = result.native && constants.isNative() && variables.isNative();
+        start = Clock::now();
+        try {
+            constant = outcome(constants.evaluate(nullptr));
+        } catch (const std::exception& e) {
+            constant = std::string("Error: ") + e.what();
+        }
+        result.jitSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+        try {
+            variable = outcome(variables.evaluate(values.data()));
+        } catch (const std::exception& e) {
+            variable = std::string("Error: ") + e.what();
+        }
+
+        if (constant != expected || variable != expected) {
+            if (result.mismatches < 5) {
+                std::cerr << "Mismatch: " << expression << "\n  expected " << expected
+                          << "\n  constants " << constant << "\n  variables " << variable << std::endl;
+            }
+            result.mismatches++;
+        }
+        result.expressions++;
+    }
+    return result;
+}
+
+void printJitCheck(const char* name, const JitCheckResult& result) {
+    std::cout << std::fixed << std::setprecision(3) << std::left << std::setw(12) << name << std::right
+              << result.expressions << " expressions, " << result.errors << " errors, "
+              << result.mismatches << " mismatches" << (result.native ? "" : " (interpreter)")
+              << ", evaluatePostfix " << result.interpreterSeconds << " s, jit " << result.jitSeconds << " s"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        GeneratorOptions options;
+        size_t count = 20000;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--count" && hasValue) count = std::stoull(argv[++i]);
+            else if (arg == "--tokens" && hasValue) options.tokens = std::stoull(argv[++i]);
+            else if (arg == "--depth" && hasValue) options.maxDepth = std::stoull(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+            else throw std::runtime_error("Unknown argument: " + arg);
+        }
+        if (!JIT_AVAILABLE) {
+            std::cout << "JIT is not available on this platform, checking the interpreter fallback" << std::endl;
+        }
+
+        // Большие литералы: переполнение 8 бит почти в каждом выражении
+        GeneratorOptions large = options;
+        large.maxValue = 127;
+        // Глубокий стек: ячейки выходят за регистры в память
+        GeneratorOptions deep = options;
+        deep.maxDepth = options.maxDepth + 3 * JIT_REGISTER_SLOTS;
+        deep.tokens = options.tokens * 4 + 1;
+
+        size_t mismatches = 0;
+        auto run = [&](const char* name, const JitCheckResult& result) {
+            printJitCheck(name, result);
+            mismatches += result.mismatches;
+        };
+        run("8 throw", checkJit<Binary<8, OVERFLOW_THROW>>(options, count));
+        run("8 throw big", checkJit<Binary<8, OVERFLOW_THROW>>(large, count));
+        run("8 wrap", checkJit<Binary<8, OVERFLOW_WRAP>>(large, count));
+        run("16 throw", checkJit<Binary<16, OVERFLOW_THROW>>(large, count));
+        run("32", checkJit<Binary32>(options, count));
+        run("8 deep", checkJit<Binary<8, OVERFLOW_THROW>>(deep, count));
+        run("32 deep", checkJit<Binary32>(deep, count));
+        return mismatches == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
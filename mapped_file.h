@@ -0,0 +1,115 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Файл, отображенный в память только для чтения.
+// Содержимое доступно как std::string_view без копирования в буфер.
+class MappedFile {
+    const char* data; // Начало отображения
+    size_t length; // Размер файла
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+
+public:
+    // Конструктор: открывает и отображает файл
+    explicit MappedFile(const std::string& path) : data(nullptr), length(0) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        mapping = nullptr;
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw std::runtime_error("Cannot get file size: " + path);
+        }
+        length = static_cast<size_t>(size.QuadPart);
+        if (length == 0) {
+            return;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (data == nullptr) {
+            if (mapping != nullptr) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            throw std::runtime_error("Cannot map file: " + path);
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot get file size: " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Cannot map file: " + path);
+            }
+            data = static_cast<const char*>(address);
+            // Файл читается последовательно: подсказка ядру читать наперед
+            madvise(address, length, MADV_SEQUENTIAL);
+        }
+        // Отображение остается действительным и после закрытия дескриптора
+        close(fd);
+#endif
+    }
+
+    // Деструктор: снимает отображение
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data != nullptr) {
+            UnmapViewOfFile(data);
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+#else
+        if (data != nullptr) {
+            munmap(const_cast<char*>(data), length);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Содержимое файла
+    std::string_view view() const {
+        return std::string_view(data, length);
+    }
+
+    // Размер файла
+    size_t size() const {
+        return length;
+    }
+};
+
+#endif
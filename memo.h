@@ -0,0 +1,352 @@
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "binary.h"
+#include "bigbinary.h"
+#include "operand_stack.h"
+#include "operators.h"
+#include "tokenizer.h"
+
+// Числовая семантика типа числа. Одно и то же выражение дает разные
+// результаты в разных семантиках (например, 8 бит с исключением при переполнении
+// и 32 бита по модулю), поэтому TAG входит в ключ каждой записи кэша.
+template <class Number> struct NumericSemantics;
+
+template <int N, OverflowPolicy POLICY> struct NumericSemantics<Binary<N, POLICY>> {
+    static constexpr uint32_t TAG = static_cast<uint32_t>(N) << 2 | static_cast<uint32_t>(POLICY);
+};
+
+template <> struct NumericSemantics<BigBinary> {
+    static constexpr uint32_t TAG = 0;
+};
+
+// Перемешивание битов 64-битного значения для хеша
+inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Статистика кэша
+struct CacheStats {
+    size_t hits = 0; // Найдено в кэше
+    size_t misses = 0; // Не найдено в кэше
+    size_t evictions = 0; // Вытеснено из-за ограничения размера
+
+    CacheStats& operator+=(const CacheStats& other) {
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+        return *this;
+    }
+};
+
+// Кэш ограниченного размера с вытеснением давно не использованных записей.
+// Ключ хранится один раз - в таблице; список порядка использования
+// хранит указатели на ключи (они не меняются при перехешировании таблицы).
+template <class Key, class Value, class Hash = std::hash<Key>>
+class LruCache {
+    typedef std::list<const Key*> Order;
+
+    struct Slot {
+        Value value; // Значение
+        typename Order::iterator position; // Место в списке порядка использования
+    };
+
+    std::unordered_map<Key, Slot, Hash> table; // Записи по ключу
+    Order order; // Ключи от недавно использованных к давно использованным
+    size_t limit; // Наибольшее число записей
+    CacheStats counters; // Статистика
+
+public:
+    explicit LruCache(size_t capacity) : limit(capacity > 0 ? capacity : 1) {}
+
+    // Поиск значения; найденная запись становится самой свежей
+    const Value* find(const Key& key) {
+        auto it = table.find(key);
+        if (it == table.end()) {
+            counters.misses++;
+            return nullptr;
+        }
+        counters.hits++;
+        order.splice(order.begin(), order, it->second.position);
+        return &it->second.value;
+    }
+
+    // Добавление записи (ключа еще нет в кэше); при переполнении
+    // вытесняется самая давняя запись
+    void insert(const Key& key, Value value) {
+        if (table.size() >= limit) {
+            table.erase(table.find(*order.back()));
+            order.pop_back();
+            counters.evictions++;
+        }
+        auto it = table.emplace(key, Slot{std::move(value), order.end()}).first;
+        order.push_front(&it->first);
+        it->second.position = order.begin();
+    }
+
+    size_t size() const {
+        return table.size();
+    }
+
+    size_t capacity() const {
+        return limit;
+    }
+
+    const CacheStats& stats() const {
+        return counters;
+    }
+};
+
+// Ключ целого выражения: нормализованный текст в заданной семантике
+struct ExpressionKey {
+    uint32_t semantics; // NumericSemantics<Number>::TAG
+    std::string text; // Токены через один пробел, числа в каноническом виде
+
+    bool operator==(const ExpressionKey& other) const {
+        return semantics == other.semantics && text == other.text;
+    }
+};
+
+struct ExpressionKeyHash {
+    size_t operator()(const ExpressionKey& key) const {
+        return static_cast<size_t>(mixHash(std::hash<std::string>()(key.text) ^ key.semantics));
+    }
+};
+
+// Ключ подвыражения "a op b": операция и номера подвыражений-операндов.
+// Одинаковые по структуре подвыражения получают один номер (hash consing),
+// поэтому сравнение ключей точное, без сравнения текста.
+struct SubtreeKey {
+    uint32_t semantics; // NumericSemantics<Number>::TAG
+    char op; // Код операции (operators.h)
+    uint64_t left; // Номер левого операнда
+    uint64_t right; // Номер правого операнда (0 у унарной операции)
+
+    bool operator==(const SubtreeKey& other) const {
+        return semantics == other.semantics && op == other.op && left == other.left && right == other.right;
+    }
+};
+
+struct SubtreeKeyHash {
+    size_t operator()(const SubtreeKey& key) const {
+        uint64_t h = mixHash(key.left ^ (static_cast<uint64_t>(key.semantics) << 8 | static_cast<uint8_t>(key.op)));
+        return static_cast<size_t>(mixHash(h ^ key.right));
+    }
+};
+
+// Вычисленное подвыражение в кэше
+template <class Number>
+struct MemoSubtree {
+    Number value; // Значение
+    uint64_t id; // Номер подвыражения
+};
+
+// Кэш вычислений постфиксных выражений одного потока.
+// Сначала ищется все выражение по нормализованному тексту; при промахе
+// выражение вычисляется, и результат каждой операции запоминается по ключу
+// (операция, номер левого операнда, номер правого операнда). Номер литерала -
+// его значение со старшим битом LEAF, номер операции выдается при первом
+// вычислении и больше не используется повторно, поэтому ключи, ссылающиеся на
+// вытесненные записи, просто перестают находиться.
+template <class Number>
+class PostfixMemo {
+    static constexpr uint32_t TAG = NumericSemantics<Number>::TAG;
+    static constexpr uint64_t LEAF = uint64_t(1) << 63;
+
+    // Операнд на стеке: значение и номер подвыражения
+    struct Operand {
+        Number value;
+        uint64_t id;
+    };
+
+    LruCache<ExpressionKey, Number, ExpressionKeyHash> expressions; // Целые выражения
+    LruCache<SubtreeKey, MemoSubtree<Number>, SubtreeKeyHash> subtrees; // Подвыражения
+    uint64_t nextId; // Номер следующего нового подвыражения
+    ExpressionKey key; // Буфер ключа, переиспользуется между выражениями
+    OperandStack<Operand> stack; // Стек операндов
+
+    // Нормализация: токены через один пробел, числа в десятичном виде без
+    // знака '+' и ведущих нулей. false - в выражении есть неверный токен
+    // (ошибку сообщит вычисление, в том же порядке, что и evaluatePostfix)
+    static bool normalize(std::string_view expression, std::string& text) {
+        text.clear();
+        Tokenizer tokenizer(expression);
+        std::string_view token;
+        while (tokenizer.next(token)) {
+            if (!text.empty()) {
+                text += ' ';
+            }
+            if (binaryOperatorCode(token) != 0 || isNotOperator(token)) {
+                text += token;
+                continue;
+            }
+            int value;
+            if (!parseInt(token, value)) {
+                return false;
+            }
+            char digits[16];
+            char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+            text.append(digits, end);
+        }
+        return true;
+    }
+
+    // Вычисление с запоминанием подвыражений
+    Number evaluateSubtrees(std::string_view expression) {
+        Tokenizer tokenizer(expression);
+        std::string_view token;
+        stack.clear();
+
+        while (tokenizer.next(token)) {
+            char op = binaryOperatorCode(token);
+            bool unary = op == 0 && isNotOperator(token);
+            if (op != 0 || unary) {
+                Operand b{Number(), 0};
+                if (!unary) {
+                    if (stack.isEmpty()) throw std::runtime_error("Invalid expression");
+                    b = stack.pop();
+                }
+
+                if (stack.isEmpty()) throw std::runtime_error("Invalid expression");
+                Operand a = stack.pop();
+
+                SubtreeKey subtree{TAG, unary ? OPERATOR_NOT : op, a.id, b.id};
+                if (const MemoSubtree<Number>* hit = subtrees.find(subtree)) {
+                    stack.push(Operand{hit->value, hit->id});
+                    continue;
+                }
+                Number result = unary ? ~a.value : applyBinaryOperator(op, a.value, b.value);
+                uint64_t id = nextId++;
+                subtrees.insert(subtree, MemoSubtree<Number>{result, id});
+                stack.push(Operand{result, id});
+            } else {
+                int value;
+                if (!parseInt(token, value)) {
+                    throw std::runtime_error("Invalid token: " + std::string(token));
+                }
+                stack.push(Operand{Number(value), LEAF | static_cast<uint32_t>(value)});
+            }
+        }
+
+        if (stack.isEmpty()) throw std::runtime_error("Invalid expression");
+
+        Number result = stack.pop().value;
+
+        if (!stack.isEmpty()) throw std::runtime_error("Invalid expression");
+
+        return result;
+    }
+
+public:
+    // capacity - наибольшее число записей в каждом из двух кэшей
+    explicit PostfixMemo(size_t capacity) : expressions(capacity), subtrees(capacity), nextId(1), key{TAG, std::string()} {}
+
+    PostfixMemo(const PostfixMemo&) = delete;
+    PostfixMemo& operator=(const PostfixMemo&) = delete;
+
+    // Вычисление выражения; результат совпадает с evaluatePostfix<Number>
+    Number evaluate(std::string_view expression) {
+        if (!normalize(expression, key.text)) {
+            return evaluateSubtrees(expression);
+        }
+        if (const Number* hit = expressions.find(key)) {
+            return *hit;
+        }
+        Number result = evaluateSubtrees(expression);
+        expressions.insert(key, result);
+        return result;
+    }
+
+    // Статистика кэша целых выражений
+    const CacheStats& expressionStats() const {
+        return expressions.stats();
+    }
+
+    // Статистика кэша подвыражений
+    const CacheStats& subtreeStats() const {
+        return subtrees.stats();
+    }
+};
+
+// Размер кэша по умолчанию (записей в каждом кэше потока)
+const size_t MEMO_DEFAULT_CAPACITY = 1 << 16;
+
+// Вычислитель для пакетного режима с кэшем вычислений.
+// У каждого потока свой кэш (без блокировок при вычислении); копии
+// вычислителя разделяют одни и те же кэши и общую статистику.
+template <class Number>
+class MemoizedEvaluator {
+    struct State {
+        uint64_t id; // Уникальный номер вычислителя
+        size_t capacity; // Размер кэша потока
+        std::mutex mutex; // Защита списка кэшей
+        std::vector<std::unique_ptr<PostfixMemo<Number>>> memos; // Кэши потоков
+    };
+
+    std::shared_ptr<State> state;
+
+    // Кэш текущего потока для этого вычислителя
+    PostfixMemo<Number>& memo() const {
+        // Номера вычислителей не повторяются, поэтому запись о
+        // разрушенном вычислителе никогда не будет найдена
+        thread_local std::unordered_map<uint64_t, PostfixMemo<Number>*> memos;
+        PostfixMemo<Number>*& memo = memos[state->id];
+        if (memo == nullptr) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->memos.push_back(std::unique_ptr<PostfixMemo<Number>>(new PostfixMemo<Number>(state->capacity)));
+            memo = state->memos.back().get();
+        }
+        return *memo;
+    }
+
+public:
+    explicit MemoizedEvaluator(size_t capacity = MEMO_DEFAULT_CAPACITY) : state(std::make_shared<State>()) {
+        static std::atomic<uint64_t> nextId(1);
+        state->id = nextId++;
+        state->capacity = capacity;
+    }
+
+    Number operator()(std::string_view expression) const {
+        return memo().evaluate(expression);
+    }
+
+    // Суммарная статистика кэшей всех потоков (вызывать после окончания вычислений)
+    void stats(CacheStats& expressions, CacheStats& subtrees) const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        for (const auto& memo : state->memos) {
+            expressions += memo->expressionStats();
+            subtrees += memo->subtreeStats();
+        }
+    }
+};
+
+// Вывод статистики кэша вычислений
+template <class Number>
+void printMemoStats(std::ostream& os, const MemoizedEvaluator<Number>& evaluator) {
+    CacheStats expressions, subtrees;
+    evaluator.stats(expressions, subtrees);
+    os << "Memo: expressions " << expressions.hits << " hits, " << expressions.misses << " misses, "
+       << expressions.evictions << " evictions; subtrees " << subtrees.hits << " hits, "
+       << subtrees.misses << " misses, " << subtrees.evictions << " evictions" << std::endl;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef OPERAND_STACK_H
+#define OPERAND_STACK_H
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "instrument.h"
+
+// Стек операндов в непрерывной памяти.
+// Первые INLINE элементов лежат во встроенном буфере (без выделения памяти),
+// при переполнении буфер растет вдвое. clear() сохраняет выделенную емкость,
+// поэтому при повторном использовании стека память больше не выделяется.
+template <class Number, size_t INLINE = 32>
+class OperandStack {
+    alignas(Number) unsigned char inlineStorage[INLINE * sizeof(Number)]; // Встроенный буфер
+    Number* items; // Начало текущего буфера
+    size_t count; // Количество элементов
+    size_t capacity; // Емкость текущего буфера
+
+    // Увеличение емкости вдвое с переносом элементов в новый буфер
+    void grow() {
+        INSTRUMENT_COUNT(pushAllocations);
+        size_t newCapacity = capacity * 2;
+        Number* newItems = static_cast<Number*>(::operator new(newCapacity * sizeof(Number)));
+        for (size_t i = 0; i < count; i++) {
+            new (newItems + i) Number(std::move(items[i]));
+            items[i].~Number();
+        }
+        release();
+        items = newItems;
+        capacity = newCapacity;
+    }
+
+    // Освобождение внешнего буфера (встроенный не освобождается)
+    void release() {
+        if (items != reinterpret_cast<Number*>(inlineStorage)) {
+            ::operator delete(items);
+        }
+    }
+
+public:
+    // Конструктор по умолчанию
+    OperandStack() : items(reinterpret_cast<Number*>(inlineStorage)), count(0), capacity(INLINE) {}
+
+    // Деструктор для очистки памяти
+    ~OperandStack() {
+        clear();
+        release();
+    }
+
+    OperandStack(const OperandStack&) = delete;
+    OperandStack& operator=(const OperandStack&) = delete;
+
+    // Функция для добавления элемента в стек
+    void push(const Number& value) {
+        if (count == capacity) {
+            // value может лежать в самом стеке - копия делается до переноса
+            Number copy(value);
+            grow();
+            new (items + count) Number(std::move(copy));
+        } else {
+            new (items + count) Number(value);
+        }
+        count++;
+    }
+
+    // Добавление с переносом (для BigBinary - без копирования разрядов)
+    void push(Number&& value) {
+        if (count == capacity) {
+            // value может лежать в самом стеке - переносится до переноса буфера
+            Number moved(std::move(value));
+            grow();
+            new (items + count) Number(std::move(moved));
+        } else {
+            new (items + count) Number(std::move(value));
+        }
+        count++;
+    }
+
+    // Функция для удаления элемента из стека
+    Number pop() {
+        if (count == 0) {
+            throw std::runtime_error("Stack is empty");
+        }
+        count--;
+        Number value(std::move(items[count]));
+        items[count].~Number();
+        return value;
+    }
+
+    // Верхний элемент стека
+    Number& top() {
+        return items[count - 1];
+    }
+
+    // Функция для проверки, пуст ли стек
+    bool isEmpty() const {
+        return count == 0;
+    }
+
+    // Количество элементов
+    size_t size() const {
+        return count;
+    }
+
+    // Удаление всех элементов с сохранением емкости
+    void clear() {
+        while (count > 0) {
+            count--;
+            items[count].~Number();
+        }
+    }
+};
+
+#endif
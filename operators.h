@@ -0,0 +1,64 @@
+#ifndef OPERATORS_H
+#define OPERATORS_H
+
+#include <string_view>
+
+// Операции постфиксной записи. Каждая операция кодируется одним символом:
+// односимвольные - самим символом, сдвиги - отдельными кодами.
+//   + - * / %   арифметика (деление с отбрасыванием дробной части)
+//   << >>       сдвиг влево и арифметический сдвиг вправо
+//   >>>         логический сдвиг вправо
+//   & | ^       побитовые И, ИЛИ, исключающее ИЛИ
+//   ~           побитовое НЕ (унарная операция)
+const char OPERATOR_SHIFT_LEFT = '<';
+const char OPERATOR_SHIFT_RIGHT = '>';
+const char OPERATOR_LOGICAL_SHIFT_RIGHT = 'r';
+const char OPERATOR_NOT = '~';
+
+// Код бинарной операции по токену (0 - токен не бинарная операция)
+constexpr char binaryOperatorCode(std::string_view token) {
+    if (token.size() == 1) {
+        switch (token[0]) {
+            case '+':
+            case '-':
+            case '*':
+            case '/':
+            case '%':
+            case '&':
+            case '|':
+            case '^':
+                return token[0];
+            default:
+                return 0;
+        }
+    }
+    if (token == "<<") return OPERATOR_SHIFT_LEFT;
+    if (token == ">>") return OPERATOR_SHIFT_RIGHT;
+    if (token == ">>>") return OPERATOR_LOGICAL_SHIFT_RIGHT;
+    return 0;
+}
+
+// Токен унарной операции НЕ
+constexpr bool isNotOperator(std::string_view token) {
+    return token.size() == 1 && token[0] == OPERATOR_NOT;
+}
+
+// Применение бинарной операции с кодом op
+template <class Number>
+constexpr Number applyBinaryOperator(char op, const Number& a, const Number& b) {
+    switch (op) {
+        case '+': return a + b;
+        case '-': return a - b;
+        case '*': return a * b;
+        case '/': return a / b;
+        case '%': return a % b;
+        case '&': return a & b;
+        case '|': return a | b;
+        case '^': return a ^ b;
+        case OPERATOR_SHIFT_LEFT: return a << b;
+        case OPERATOR_SHIFT_RIGHT: return a >> b;
+        default: return a.logicalShiftRight(b);
+    }
+}
+
+#endif
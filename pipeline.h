@@ -0,0 +1,378 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "batch.h"
+#include "evaluation.h"
+#include "format.h"
+#include "operand_stack.h"
+#include "operators.h"
+#include "tokenizer.h"
+
+// Кольцевой буфер ограниченного размера для одного писателя и одного
+// читателя без блокировок. Каждый индекс пишет только своя сторона;
+// копия чужого индекса обновляется, только когда по ней буфер кажется
+// полным (пустым), поэтому строки кэша индексов почти не перебрасываются.
+template <class T>
+class SpscRing {
+    std::vector<T> slots; // Ячейки (размер - степень двойки)
+    size_t mask; // slots.size() - 1
+    alignas(64) std::atomic<size_t> head; // Номер следующей ячейки для чтения
+    size_t cachedTail; // Копия tail у читателя
+    alignas(64) std::atomic<size_t> tail; // Номер следующей ячейки для записи
+    size_t cachedHead; // Копия head у писателя
+
+public:
+    explicit SpscRing(size_t capacity) : head(0), cachedTail(0), tail(0), cachedHead(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Запись (только писатель); false - буфер полон, value не тронут
+    bool tryPush(T& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead == slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead == slots.size()) {
+                return false;
+            }
+        }
+        slots[position & mask] = std::move(value);
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Чтение (только читатель); false - буфер пуст
+    bool tryPop(T& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail) {
+                return false;
+            }
+        }
+        value = std::move(slots[position & mask]);
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Статистика стадии конвейера. Медленная стадия почти все время занята
+// (busy), стадии после нее ждут входа (starved), стадии до нее ждут места
+// в выходной очереди (blocked).
+struct StageStats {
+    size_t batches = 0; // Обработано пачек
+    double busySeconds = 0; // Время работы
+    double starvedSeconds = 0; // Время ожидания входа
+    double blockedSeconds = 0; // Время ожидания места в выходной очереди
+    size_t starvedWaits = 0; // Сколько раз вход оказывался пуст
+    size_t blockedWaits = 0; // Сколько раз выход оказывался полон
+};
+
+// Статистика конвейера по стадиям
+struct PipelineStats {
+    StageStats reader; // Чтение входа
+    StageStats tokenizer; // Разбор на токены
+    StageStats evaluator; // Вычисление и вывод
+};
+
+// Ожидание очереди: сначала короткое активное ожидание, затем уступка процессора
+inline void pipelinePause(unsigned& spins) {
+    if (++spins < 64) {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+// Запись в очередь с ожиданием места; время ожидания - в blocked
+template <class T>
+void pipelinePush(SpscRing<T>& ring, T& value, StageStats& stats) {
+    if (ring.tryPush(value)) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    unsigned spins = 0;
+    while (!ring.tryPush(value)) {
+        pipelinePause(spins);
+    }
+    stats.blockedWaits++;
+    stats.blockedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Чтение из очереди с ожиданием данных; время ожидания - в starved
+template <class T>
+void pipelinePop(SpscRing<T>& ring, T& value, StageStats& stats) {
+    if (ring.tryPop(value)) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    unsigned spins = 0;
+    while (!ring.tryPop(value)) {
+        pipelinePause(spins);
+    }
+    stats.starvedWaits++;
+    stats.starvedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Объем одного чтения входа
+const size_t PIPELINE_BLOCK_BYTES = 64 * 1024;
+// Пачек в каждой очереди между стадиями
+const size_t PIPELINE_QUEUE_BATCHES = 8;
+// Код неверного токена (остальные коды - из operators.h, 0 - число)
+const char PIPELINE_BAD_TOKEN = '?';
+
+// Пачка целых строк входа
+struct TextBatch {
+    std::string text; // Строки; последняя строка входа может быть без '\n'
+    bool end = false; // Вход закончился, пачка пустая
+};
+
+// Разобранный токен
+struct PipelineToken {
+    char op; // Код операции, 0 - число, PIPELINE_BAD_TOKEN - неверный токен
+    uint32_t offset; // Смещение токена от начала строки (для места ошибки)
+    int32_t value; // Число
+};
+
+// Разобранная строка пачки
+struct PipelineLine {
+    uint32_t start; // Смещение строки в тексте пачки
+    uint32_t length; // Длина строки без '\n'
+    uint32_t tokensEnd; // Номер токена после последнего токена строки
+};
+
+// Пачка разобранных строк
+struct TokenBatch {
+    std::string text; // Текст строк (для сообщений об ошибках)
+    std::vector<PipelineToken> tokens; // Токены всех строк подряд
+    std::vector<PipelineLine> lines; // Строки пачки
+    bool end = false; // Вход закончился, пачка пустая
+};
+
+// Стадия чтения: блоки входа режутся по последнему '\n', хвост переносится
+// в следующую пачку
+inline void pipelineReader(std::istream& in, SpscRing<TextBatch>& output, StageStats& stats) {
+    std::string rest;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        TextBatch batch;
+        batch.text.swap(rest);
+        size_t size = batch.text.size();
+        batch.text.resize(size + PIPELINE_BLOCK_BYTES);
+        in.read(&batch.text[size], static_cast<std::streamsize>(PIPELINE_BLOCK_BYTES));
+        size_t count = static_cast<size_t>(in.gcount());
+        batch.text.resize(size + count);
+        bool finished = count == 0;
+        if (!finished) {
+            size_t end = batch.text.rfind('\n');
+            if (end == std::string::npos) {
+                rest.swap(batch.text); // Строка длиннее блока - читается дальше
+                continue;
+            }
+            rest.assign(batch.text, end + 1, std::string::npos);
+            batch.text.resize(end + 1);
+        }
+        stats.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!batch.text.empty()) {
+            stats.batches++;
+            pipelinePush(output, batch, stats);
+        }
+        if (finished) {
+            TextBatch last;
+            last.end = true;
+            pipelinePush(output, last, stats);
+            return;
+        }
+    }
+}
+
+// Стадия разбора: строки пачки разбираются на токены, числа переводятся из текста
+inline void pipelineTokenizer(SpscRing<TextBatch>& input, SpscRing<TokenBatch>& output, StageStats& stats) {
+    TextBatch text;
+    while (true) {
+        pipelinePop(input, text, stats);
+        if (text.end) {
+            TokenBatch last;
+            last.end = true;
+            pipelinePush(output, last, stats);
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        TokenBatch batch;
+        batch.text = std::move(text.text);
+        std::string_view rest = batch.text;
+        while (!rest.empty()) {
+            size_t end = rest.find('\n');
+            if (end == std::string_view::npos) {
+                end = rest.size();
+            }
+            std::string_view line = rest.substr(0, end);
+            Tokenizer tokenizer(line);
+            std::string_view token;
+            while (tokenizer.next(token)) {
+                PipelineToken parsed{binaryOperatorCode(token), static_cast<uint32_t>(token.data() - line.data()), 0};
+                if (parsed.op == 0 && isNotOperator(token)) {
+                    parsed.op = OPERATOR_NOT;
+                } else if (parsed.op == 0 && !parseInt(token, parsed.value)) {
+                    parsed.op = PIPELINE_BAD_TOKEN;
+                }
+                batch.tokens.push_back(parsed);
+            }
+            batch.lines.push_back(PipelineLine{static_cast<uint32_t>(line.data() - batch.text.data()),
+                                               static_cast<uint32_t>(line.size()),
+                                               static_cast<uint32_t>(batch.tokens.size())});
+            rest.remove_prefix(end == rest.size() ? end : end + 1);
+        }
+        stats.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.batches++;
+        pipelinePush(output, batch, stats);
+    }
+}
+
+// Токен строки, начинающийся со смещения offset
+inline std::string_view tokenAt(std::string_view line, size_t offset) {
+    Tokenizer tokenizer(line.substr(offset));
+    std::string_view token;
+    tokenizer.next(token);
+    return token;
+}
+
+// Вычисление одной разобранной строки без исключений; ошибки и их места
+// те же, что у tryEvaluatePostfix
+template <class Number>
+EvaluationResult<Number> evaluateTokens(const TokenBatch& batch, size_t begin, const PipelineLine& line) {
+    thread_local OperandStack<Number> stack;
+    stack.clear();
+    std::string_view expression = std::string_view(batch.text).substr(line.start, line.length);
+    auto failure = [&](EvaluationErrorCode code, const PipelineToken& token) {
+        return evaluationError(code, expression, tokenAt(expression, token.offset));
+    };
+    for (size_t i = begin; i < line.tokensEnd; i++) {
+        const PipelineToken& token = batch.tokens[i];
+        if (token.op == 0) {
+            Number number;
+            EvaluationErrorCode code = tryMakeNumber(token.value, number);
+            if (code != EVALUATION_OK) return failure(code, token);
+            stack.push(std::move(number));
+        } else if (token.op == PIPELINE_BAD_TOKEN) {
+            return failure(EVALUATION_BAD_TOKEN, token);
+        } else if (token.op == OPERATOR_NOT) {
+            if (stack.isEmpty()) return failure(EVALUATION_STACK_UNDERFLOW, token);
+            stack.push(~stack.pop());
+        } else {
+            if (stack.size() < 2) return failure(EVALUATION_STACK_UNDERFLOW, token);
+            Number b = stack.pop();
+            Number a = stack.pop();
+            Number result;
+            EvaluationErrorCode code = tryApplyBinaryOperator(token.op, a, b, result);
+            if (code != EVALUATION_OK) return failure(code, token);
+            stack.push(std::move(result));
+        }
+    }
+
+    if (stack.isEmpty()) return evaluationErrorAtEnd(EVALUATION_STACK_UNDERFLOW, expression);
+
+    Number result = stack.pop();
+
+    if (!stack.isEmpty()) return evaluationErrorAtEnd(EVALUATION_LEFTOVER_OPERANDS, expression);
+
+    return result;
+}
+
+// Пакетная обработка конвейером из трех стадий: чтение, разбор на токены и
+// вычисление с выводом работают одновременно в разных потоках и передают
+// друг другу пачки через SpscRing. Вывод совпадает с runBatch и evaluatePostfix.
+template <class Number>
+BatchStats runPipelinedBatch(std::istream& in, std::ostream& out, PipelineStats& pipeline, FormatMode mode = FORMAT_BINARY) {
+    BatchStats stats;
+    auto start = std::chrono::steady_clock::now();
+    SpscRing<TextBatch> texts(PIPELINE_QUEUE_BATCHES);
+    SpscRing<TokenBatch> tokens(PIPELINE_QUEUE_BATCHES);
+    // std::cin привязан к std::cout и сбрасывает его при чтении; чтение идет
+    // в другом потоке, поэтому на время работы конвейера привязка снимается
+    std::ostream* tied = in.tie(nullptr);
+    std::thread reader(pipelineReader, std::ref(in), std::ref(texts), std::ref(pipeline.reader));
+    std::thread tokenizer(pipelineTokenizer, std::ref(texts), std::ref(tokens), std::ref(pipeline.tokenizer));
+
+    OutputBuffer buffer(out, mode);
+    TokenBatch batch;
+    while (true) {
+        pipelinePop(tokens, batch, pipeline.evaluator);
+        if (batch.end) {
+            break;
+        }
+        auto batchStart = std::chrono::steady_clock::now();
+        size_t begin = 0;
+        for (const PipelineLine& line : batch.lines) {
+            stats.expressions++;
+            stats.tokens += line.tokensEnd - begin;
+            EvaluationResult<Number> result = evaluateTokens<Number>(batch, begin, line);
+            if (result) {
+                buffer.appendResult(result.value());
+            } else {
+                stats.failed++;
+                buffer.appendError(result.error().message());
+            }
+            begin = line.tokensEnd;
+        }
+        pipeline.evaluator.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+        pipeline.evaluator.batches++;
+    }
+    buffer.flush();
+    out.flush();
+    reader.join();
+    tokenizer.join();
+    in.tie(tied);
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Конвейер для файла или, если имя файла пустое, стандартного ввода
+template <class Number>
+BatchStats runPipelinedInput(const std::string& inputFile, std::ostream& out, PipelineStats& pipeline,
+                             FormatMode mode = FORMAT_BINARY) {
+    if (inputFile.empty()) {
+        return runPipelinedBatch<Number>(std::cin, out, pipeline, mode);
+    }
+    std::ifstream file(inputFile, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open file: " + inputFile);
+    }
+    return runPipelinedBatch<Number>(file, out, pipeline, mode);
+}
+
+// Вывод статистики стадий конвейера
+inline void printPipelineStats(std::ostream& os, const PipelineStats& stats) {
+    auto printStage = [&](const char* name, const StageStats& stage) {
+        os << "  " << name << ": " << stage.batches << " batches, busy " << stage.busySeconds
+           << " s, starved " << stage.starvedSeconds << " s (" << stage.starvedWaits << " waits), blocked "
+           << stage.blockedSeconds << " s (" << stage.blockedWaits << " waits)" << std::endl;
+    };
+    os << "Pipeline:" << std::endl;
+    printStage("reader", stats.reader);
+    printStage("tokenizer", stats.tokenizer);
+    printStage("evaluator", stats.evaluator);
+}
+
+#endif
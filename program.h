@@ -0,0 +1,470 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "batch.h"
+#include "evaluation.h"
+#include "format.h"
+#include "mapped_file.h"
+#include "operators.h"
+#include "tokenizer.h"
+
+// Двоичный формат постфиксных программ: выражения уже разобраны на токены,
+// поэтому при вычислении нет ни разбора текста, ни перевода чисел из строк.
+// Файл: заголовок из PROGRAM_HEADER_BYTES байт ("PFXB", версия формата,
+// три нулевых байта), затем записи программ подряд. Запись: количество
+// токенов исходного выражения, наибольшая глубина стека и длина кода в байтах
+// (все три - varint), затем код. Код - поток операций по одному байту:
+//   + - * / % & | ^ < > r ~   операции с кодами из operators.h
+//   0x80..0xFF                число от -64 до 63 прямо в байте операции
+//   PROGRAM_VARINT            число в следующих байтах (varint, zigzag)
+//   PROGRAM_FIXED             число в следующих 4 байтах (little-endian)
+//   PROGRAM_ERROR             ошибка в записи выражения: код ошибки (байт),
+//                             смещение токена (varint), длина токена (varint), токен
+// varint - по 7 бит в байте начиная с младших, старший бит - признак продолжения.
+// Ошибки, которые зависят от типа чисел (переполнение, деление на ноль), находятся
+// при вычислении; их место - номер токена в программе, а не смещение в тексте.
+
+// Начало файла программ
+const char PROGRAM_MAGIC[] = "PFXB";
+// Версия формата
+const uint8_t PROGRAM_VERSION = 1;
+// Размер заголовка файла
+const size_t PROGRAM_HEADER_BYTES = 8;
+
+// Коды операций кроме операций operators.h
+enum ProgramOpcode : uint8_t {
+    PROGRAM_VARINT = 1, // Число в varint
+    PROGRAM_FIXED = 2, // Число в 4 байтах
+    PROGRAM_ERROR = 3, // Ошибка выражения (последняя операция программы)
+    PROGRAM_SMALL = 0x80 // Первый код числа в байте операции
+};
+
+// Числа, которые помещаются в байт операции
+const int PROGRAM_SMALL_MIN = -64;
+const int PROGRAM_SMALL_MAX = 63;
+
+// Запись varint
+inline void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Чтение varint из [p, end); false, если запись обрывается или длиннее 64 бит
+inline bool readVarint(const unsigned char*& p, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        unsigned char byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Является ли байт кодом операции operators.h
+inline bool isProgramOperator(unsigned char op) {
+    switch (op) {
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+        case '&':
+        case '|':
+        case '^':
+        case OPERATOR_SHIFT_LEFT:
+        case OPERATOR_SHIFT_RIGHT:
+        case OPERATOR_LOGICAL_SHIFT_RIGHT:
+        case OPERATOR_NOT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Запись программ в поток. Программу можно построить по токенам
+// (literal, operation, finish) - так ее пишут генераторы выражений без
+// печати в текст, или перевести из текста выражения (write).
+class ProgramWriter {
+    std::ostream& out; // Поток файла программ
+    std::string code; // Код текущей программы
+    std::string record; // Буфер записи
+    uint64_t tokens = 0; // Токенов в текущей программе
+    size_t depth = 0; // Глубина стека после последней операции
+    size_t maxDepth = 0; // Наибольшая глубина стека
+    size_t count = 0; // Записано программ
+
+    void appendLiteral(int value) {
+        if (value >= PROGRAM_SMALL_MIN && value <= PROGRAM_SMALL_MAX) {
+            code += static_cast<char>(PROGRAM_SMALL + (value - PROGRAM_SMALL_MIN));
+            return;
+        }
+        uint32_t bits = static_cast<uint32_t>(value);
+        uint32_t zigzag = (bits << 1) ^ (value < 0 ? 0xFFFFFFFFu : 0);
+        if (zigzag < (1u << 28)) {
+            // Не больше 4 байт
+            code += static_cast<char>(PROGRAM_VARINT);
+            appendVarint(code, zigzag);
+        } else {
+            code += static_cast<char>(PROGRAM_FIXED);
+            for (int i = 0; i < 4; i++) {
+                code += static_cast<char>(bits >> (8 * i));
+            }
+        }
+    }
+
+    void push() {
+        depth++;
+        maxDepth = std::max(maxDepth, depth);
+    }
+
+    // Запись текущей программы и начало следующей
+    void writeRecord(uint64_t tokenCount) {
+        record.clear();
+        appendVarint(record, tokenCount);
+        appendVarint(record, maxDepth);
+        appendVarint(record, code.size());
+        record += code;
+        out.write(record.data(), static_cast<std::streamsize>(record.size()));
+        code.clear();
+        tokens = 0;
+        depth = 0;
+        maxDepth = 0;
+        count++;
+    }
+
+public:
+    // Конструктор: записывает заголовок файла
+    explicit ProgramWriter(std::ostream& _out) : out(_out) {
+        char header[PROGRAM_HEADER_BYTES] = {PROGRAM_MAGIC[0], PROGRAM_MAGIC[1], PROGRAM_MAGIC[2], PROGRAM_MAGIC[3],
+                                             static_cast<char>(PROGRAM_VERSION), 0, 0, 0};
+        out.write(header, PROGRAM_HEADER_BYTES);
+    }
+
+    // Число в текущей программе
+    void literal(int value) {
+        appendLiteral(value);
+        tokens++;
+        push();
+    }
+
+    // Операция с кодом из operators.h в текущей программе
+    void operation(char op) {
+        if (!isProgramOperator(static_cast<unsigned char>(op))) {
+            throw std::runtime_error("Invalid operation code");
+        }
+        if (depth < (op == OPERATOR_NOT ? 1u : 2u)) {
+            throw std::runtime_error("Invalid expression");
+        }
+        code += op;
+        tokens++;
+        if (op != OPERATOR_NOT) {
+            depth--;
+        }
+    }
+
+    // Конец текущей программы: в стеке должно остаться одно число
+    void finish() {
+        if (depth != 1) {
+            throw std::runtime_error("Invalid expression");
+        }
+        writeRecord(tokens);
+    }
+
+    // Перевод текстового выражения в программу. Выражение с ошибкой в записи
+    // (неверный токен, нехватка или лишние операнды) тоже записывается: код до
+    // ошибки и операция PROGRAM_ERROR, поэтому вычисление программы вернет ту же
+    // ошибку, что и tryEvaluatePostfix. Возвращает эту ошибку (или EVALUATION_OK).
+    EvaluationError write(std::string_view expression) {
+        code.clear();
+        tokens = 0;
+        depth = 0;
+        maxDepth = 0;
+        Tokenizer tokenizer(expression);
+        std::string_view token;
+        EvaluationError error;
+        while (tokenizer.next(token)) {
+            char op = binaryOperatorCode(token);
+            if (op == 0 && isNotOperator(token)) {
+                op = OPERATOR_NOT;
+            }
+            if (op != 0) {
+                if (depth < (op == OPERATOR_NOT ? 1u : 2u)) {
+                    error = evaluationError(EVALUATION_STACK_UNDERFLOW, expression, token);
+                    break;
+                }
+                code += op;
+                if (op != OPERATOR_NOT) {
+                    depth--;
+                }
+            } else {
+                int value;
+                if (!parseInt(token, value)) {
+                    error = evaluationError(EVALUATION_BAD_TOKEN, expression, token);
+                    break;
+                }
+                appendLiteral(value);
+                push();
+            }
+        }
+        if (error.code == EVALUATION_OK && depth != 1) {
+            error = evaluationErrorAtEnd(depth == 0 ? EVALUATION_STACK_UNDERFLOW : EVALUATION_LEFTOVER_OPERANDS,
+                                         expression);
+        }
+        if (error.code != EVALUATION_OK) {
+            code += static_cast<char>(PROGRAM_ERROR);
+            code += static_cast<char>(error.code);
+            appendVarint(code, error.offset);
+            appendVarint(code, error.token.size());
+            code.append(error.token.data(), error.token.size());
+        }
+        writeRecord(countTokens(expression));
+        return error;
+    }
+
+    // Записано программ
+    size_t programs() const {
+        return count;
+    }
+};
+
+// Программа из файла: код указывает в отображенный файл
+struct Program {
+    uint64_t tokens = 0; // Токенов исходного выражения
+    size_t maxDepth = 0; // Наибольшая глубина стека
+    std::string_view code; // Код
+};
+
+// Записи программ файла (после проверки заголовка)
+inline std::string_view programRecords(std::string_view file) {
+    if (file.size() < PROGRAM_HEADER_BYTES || file.substr(0, 4) != std::string_view(PROGRAM_MAGIC, 4)) {
+        throw std::runtime_error("Invalid program file");
+    }
+    if (static_cast<uint8_t>(file[4]) != PROGRAM_VERSION) {
+        throw std::runtime_error("Unsupported program file version " +
+                                 std::to_string(static_cast<uint8_t>(file[4])));
+    }
+    return file.substr(PROGRAM_HEADER_BYTES);
+}
+
+// Чтение записи, начинающейся в records с позиции pos; false в конце записей.
+// Запись, которая не помещается в файл, - исключение (файл обрезан или испорчен).
+inline bool nextProgram(std::string_view records, size_t& pos, Program& program) {
+    if (pos == records.size()) {
+        return false;
+    }
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(records.data());
+    const unsigned char* p = begin + pos;
+    const unsigned char* end = begin + records.size();
+    uint64_t tokens, maxDepth, length;
+    // Каждое число кода занимает хотя бы байт, поэтому глубина не больше длины
+    // кода и стек для записи из испорченного файла не больше самого файла
+    if (!readVarint(p, end, tokens) || !readVarint(p, end, maxDepth) || !readVarint(p, end, length) ||
+        length > static_cast<uint64_t>(end - p) || maxDepth > length) {
+        throw std::runtime_error("Invalid program file");
+    }
+    program.tokens = tokens;
+    program.maxDepth = static_cast<size_t>(maxDepth);
+    program.code = records.substr(static_cast<size_t>(p - begin), static_cast<size_t>(length));
+    pos = static_cast<size_t>(p - begin) + static_cast<size_t>(length);
+    return true;
+}
+
+// Ошибка, записанная операцией PROGRAM_ERROR (p - после кода операции).
+// Токен ошибки указывает в код программы.
+inline EvaluationError readProgramError(const unsigned char* p, const unsigned char* end, size_t index) {
+    uint64_t offset, length;
+    if (p == end || *p == EVALUATION_OK || *p > EVALUATION_INVALID_PROGRAM) {
+        return EvaluationError{EVALUATION_INVALID_PROGRAM, index, std::string_view()};
+    }
+    EvaluationErrorCode code = static_cast<EvaluationErrorCode>(*p++);
+    if (!readVarint(p, end, offset) || !readVarint(p, end, length) || length != static_cast<uint64_t>(end - p)) {
+        return EvaluationError{EVALUATION_INVALID_PROGRAM, index, std::string_view()};
+    }
+    return EvaluationError{code, static_cast<size_t>(offset),
+                           std::string_view(reinterpret_cast<const char*>(p), static_cast<size_t>(length))};
+}
+
+// Вычисление программы. Стек - массив глубины из заголовка записи, числа
+// берутся из кода готовыми. Испорченный код (неизвестная операция, нехватка
+// операндов, выход за глубину из заголовка) - ошибка EVALUATION_INVALID_PROGRAM.
+template <class Number>
+EvaluationResult<Number> tryEvaluateProgram(const Program& program) {
+    thread_local std::vector<Number> stack;
+    if (stack.size() < program.maxDepth) {
+        stack.resize(program.maxDepth);
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(program.code.data());
+    const unsigned char* end = p + program.code.size();
+    size_t depth = 0;
+    EvaluationError invalid{EVALUATION_INVALID_PROGRAM, 0, std::string_view()};
+    for (size_t index = 0; p < end; index++) {
+        unsigned char op = *p++;
+        invalid.offset = index;
+        int value;
+        if (op >= PROGRAM_SMALL) {
+            value = static_cast<int>(op - PROGRAM_SMALL) + PROGRAM_SMALL_MIN;
+        } else if (op == PROGRAM_VARINT) {
+            uint64_t zigzag;
+            if (!readVarint(p, end, zigzag) || zigzag > 0xFFFFFFFFu) return invalid;
+            uint32_t bits = static_cast<uint32_t>(zigzag);
+            value = static_cast<int>((bits >> 1) ^ (0u - (bits & 1)));
+        } else if (op == PROGRAM_FIXED) {
+            if (end - p < 4) return invalid;
+            uint32_t bits = static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+                            static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+            value = static_cast<int>(bits);
+            p += 4;
+        } else if (op == PROGRAM_ERROR) {
+            return readProgramError(p, end, index);
+        } else if (op == OPERATOR_NOT) {
+            if (depth == 0) return invalid;
+            stack[depth - 1] = ~stack[depth - 1];
+            continue;
+        } else {
+            if (depth < 2 || !isProgramOperator(op)) return invalid;
+            Number result;
+            EvaluationErrorCode code = tryApplyBinaryOperator(static_cast<char>(op), stack[depth - 2], stack[depth - 1], result);
+            if (code != EVALUATION_OK) return EvaluationError{code, index, std::string_view()};
+            depth--;
+            stack[depth - 1] = std::move(result);
+            continue;
+        }
+        if (depth == program.maxDepth) return invalid;
+        EvaluationErrorCode code = tryMakeNumber(value, stack[depth]);
+        if (code != EVALUATION_OK) return EvaluationError{code, index, std::string_view()};
+        depth++;
+    }
+    if (depth != 1) return invalid;
+    return std::move(stack[0]);
+}
+
+// Вычисление всех записей куска с выводом результата или ошибки на месте каждой
+template <class Number>
+void evaluatePrograms(std::string_view records, OutputBuffer& out, BatchStats& stats) {
+    Program program;
+    size_t pos = 0;
+    while (nextProgram(records, pos, program)) {
+        stats.expressions++;
+        stats.tokens += program.tokens;
+        EvaluationResult<Number> result = tryEvaluateProgram<Number>(program);
+        if (result) {
+            out.appendResult(result.value());
+        } else {
+            stats.failed++;
+            out.appendError(result.error().message());
+        }
+    }
+}
+
+// Пакетное вычисление файла программ в памяти; вывод тот же, что у пакетного
+// режима на исходном тексте. Параллельно куски записей около BATCH_CHUNK_BYTES
+// вычисляются в пуле (границы записей проверяются при нарезке).
+template <class Number>
+BatchStats runPrograms(std::string_view file, std::ostream& out, bool parallel, FormatMode mode = FORMAT_BINARY) {
+    std::string_view records = programRecords(file);
+    if (!parallel) {
+        BatchStats stats;
+        auto start = std::chrono::steady_clock::now();
+        OutputBuffer buffer(out, mode);
+        evaluatePrograms<Number>(records, buffer, stats);
+        buffer.flush();
+        out.flush();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+    auto nextChunk = [&](BatchChunk& chunk) {
+        size_t pos = 0;
+        Program program;
+        while (pos < BATCH_CHUNK_BYTES && nextProgram(records, pos, program)) {
+        }
+        chunk.text = records.substr(0, pos);
+        records.remove_prefix(pos);
+        return pos != 0;
+    };
+    auto evaluateChunk = [](std::string_view text, OutputBuffer& buffer, BatchStats& stats) {
+        evaluatePrograms<Number>(text, buffer, stats);
+    };
+    return runChunked(nextChunk, out, evaluateChunk, 0, mode);
+}
+
+// Вычисление файла программ (он отображается в память) или, если имя
+// файла пустое, программ из стандартного ввода
+template <class Number>
+BatchStats runProgramInput(const std::string& inputFile, std::ostream& out, bool parallel,
+                           FormatMode mode = FORMAT_BINARY) {
+    if (!inputFile.empty()) {
+        MappedFile mapped(inputFile);
+        return runPrograms<Number>(mapped.view(), out, parallel, mode);
+    }
+    std::string file((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    return runPrograms<Number>(file, out, parallel, mode);
+}
+
+// Перевод одной строки в программу. failed - выражения с ошибкой в записи.
+inline void writeProgramLine(std::string_view line, ProgramWriter& writer, BatchStats& stats) {
+    stats.expressions++;
+    stats.tokens += countTokens(line);
+    if (writer.write(line).code != EVALUATION_OK) {
+        stats.failed++;
+    }
+}
+
+// Перевод текста (выражение в каждой строке, последняя строка может быть
+// без '\n') в программы
+inline void writePrograms(std::string_view text, ProgramWriter& writer, BatchStats& stats) {
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        writeProgramLine(text.substr(0, end), writer, stats);
+        text.remove_prefix(end == text.size() ? end : end + 1);
+    }
+}
+
+// Перевод текстового пакетного входа из файла или, если имя файла пустое,
+// из стандартного ввода в файл программ outputFile
+inline BatchStats writeProgramsInput(const std::string& inputFile, const std::string& outputFile) {
+    BatchStats stats;
+    auto start = std::chrono::steady_clock::now();
+    std::ofstream out(outputFile, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open file: " + outputFile);
+    }
+    ProgramWriter writer(out);
+    if (!inputFile.empty()) {
+        MappedFile mapped(inputFile);
+        writePrograms(mapped.view(), writer, stats);
+    } else {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            writeProgramLine(line, writer, stats);
+        }
+    }
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Cannot write file: " + outputFile);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+#endif
@@ -0,0 +1,525 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Формат ответа сервера: на каждую строку запроса - один кадр из 4 байт
+// длины (little-endian) и текста результата ("Error: ..." при ошибке).
+// Кадры идут в порядке строк запроса.
+const size_t FRAME_HEADER_BYTES = 4;
+
+// Запись длины кадра, начинающегося в out с позиции header (текст
+// кадра - все после заголовка до конца out)
+inline void setFrameLength(std::string& out, size_t header) {
+    uint32_t length = static_cast<uint32_t>(out.size() - header - FRAME_HEADER_BYTES);
+    for (size_t i = 0; i < FRAME_HEADER_BYTES; i++) {
+        out[header + i] = static_cast<char>(length >> (8 * i) & 0xff);
+    }
+}
+
+// Добавление кадра в буфер
+inline void appendFrame(std::string& out, std::string_view payload) {
+    size_t header = out.size();
+    out.append(FRAME_HEADER_BYTES, '\0');
+    out.append(payload.data(), payload.size());
+    setFrameLength(out, header);
+}
+
+// Разбор кадра в начале буфера: false - кадр еще не получен целиком
+inline bool parseFrame(std::string_view buffer, std::string_view& payload, size_t& frameBytes) {
+    if (buffer.size() < FRAME_HEADER_BYTES) {
+        return false;
+    }
+    uint32_t length = 0;
+    for (size_t i = 0; i < FRAME_HEADER_BYTES; i++) {
+        length |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[i])) << (8 * i);
+    }
+    if (buffer.size() - FRAME_HEADER_BYTES < length) {
+        return false;
+    }
+    payload = buffer.substr(FRAME_HEADER_BYTES, length);
+    frameBytes = FRAME_HEADER_BYTES + length;
+    return true;
+}
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "batch.h"
+#include "evaluation.h"
+#include "format.h"
+#include "thread_pool.h"
+
+// Статистика сервера
+struct ServerStats {
+    size_t connections = 0; // Принято соединений
+    size_t expressions = 0; // Вычислено выражений
+    size_t failed = 0; // Из них с ошибкой
+    size_t bytesIn = 0; // Получено байт
+    size_t bytesOut = 0; // Отправлено байт
+};
+
+// Ошибка системного вызова
+inline std::runtime_error systemError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Сервер вычислений на локальном сокете (Unix domain socket).
+// Клиент шлет выражения строками, не дожидаясь ответов (конвейер); сервер
+// отвечает кадрами appendFrame в том же порядке.
+//
+// Главный поток обслуживает все соединения через epoll: принимает клиентов,
+// читает запросы и пишет ответы. Прочитанные целые строки одного соединения
+// уходят пачкой в пул потоков; готовая пачка возвращается главному потоку
+// через очередь и eventfd и выводится в порядке номеров пачек соединения.
+// Стеки операндов потоков пула (thread_local в вычислителях), буферы
+// форматирования и кэш MemoizedEvaluator живут все время работы сервера и
+// прогреваются от запроса к запросу.
+// Работа заканчивается по SIGINT или SIGTERM.
+template <class Evaluate>
+class EvaluatorServer {
+    // Наибольший объем одного чтения из сокета
+    static constexpr size_t READ_BYTES = 64 * 1024;
+    // Соединение не читается, пока у него столько пачек в работе
+    // или столько байт ответа не отправлено
+    static constexpr size_t MAX_IN_FLIGHT = 16;
+    static constexpr size_t MAX_PENDING_OUTPUT = 4 * 1024 * 1024;
+    // Наибольшая длина строки запроса: более длинная строка не копится,
+    // на ее месте клиент получает кадр с ошибкой
+    static constexpr size_t MAX_LINE_BYTES = 1024 * 1024;
+
+    // Соединение с клиентом
+    struct Connection {
+        int fd = -1;
+        std::string input; // Недочитанная последняя строка
+        std::string output; // Кадры, еще не отправленные клиенту
+        size_t written = 0; // Отправлено байт из начала output
+        uint64_t nextBatch = 0; // Номер следующей пачки на вычисление
+        uint64_t nextOutput = 0; // Номер пачки, ответ которой выводится следующим
+        std::map<uint64_t, std::string> ready; // Вычисленные пачки, ожидающие своей очереди
+        bool peerClosed = false; // Клиент закрыл свою сторону
+        bool skipping = false; // Остаток слишком длинной строки пропускается до '\n'
+        uint32_t events = 0; // Текущая подписка epoll
+    };
+
+    // Вычисленная пачка
+    struct Completion {
+        uint64_t connection; // Номер соединения
+        uint64_t batch; // Номер пачки в соединении
+        std::string frames; // Кадры ответов
+        size_t expressions; // Выражений в пачке
+        size_t failed; // Из них с ошибкой
+    };
+
+    std::string path; // Путь к сокету
+    Evaluate evaluate; // Вычислитель, общий для всех потоков
+    unsigned threads; // Потоков в пуле (0 - по числу ядер)
+    int listener = -1;
+    int epoll = -1;
+    int wakeup = -1; // eventfd: есть вычисленные пачки
+    int signals = -1; // signalfd: SIGINT и SIGTERM
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections; // По номеру соединения
+    // Номера 0-2 в epoll - служебные дескрипторы, соединения нумеруются с 3
+    static constexpr uint64_t LISTENER = 0, WAKEUP = 1, SIGNALS = 2;
+    uint64_t nextConnection = 3; // Номер следующего соединения
+    std::mutex mutex; // Защита completed и spare
+    std::vector<Completion> completed; // Вычисленные пачки для главного потока
+    std::vector<std::string> spare; // Буферы пачек для повторного использования
+    ServerStats counters;
+
+    // Буфер из запаса (с уже выделенной памятью) или новый
+    std::string takeBuffer() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare.empty()) {
+            return std::string();
+        }
+        std::string buffer = std::move(spare.back());
+        spare.pop_back();
+        return buffer;
+    }
+
+    void returnBuffer(std::string&& buffer) {
+        buffer.clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare.size() < 4 * MAX_IN_FLIGHT) {
+            spare.push_back(std::move(buffer));
+        }
+    }
+
+    // Подписка epoll на дескриптор; data - номер соединения
+    void watch(int fd, uint64_t data, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = data;
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+            throw systemError("Cannot watch descriptor");
+        }
+    }
+
+    // Обновление подписки соединения: чтение - пока не превышены пределы,
+    // запись - пока есть неотправленные кадры
+    void updateEvents(uint64_t id, Connection& connection) {
+        uint32_t events = 0;
+        if (!connection.peerClosed && connection.nextBatch - connection.nextOutput < MAX_IN_FLIGHT &&
+            connection.output.size() - connection.written < MAX_PENDING_OUTPUT) {
+            events |= EPOLLIN;
+        }
+        if (connection.written < connection.output.size()) {
+            events |= EPOLLOUT;
+        }
+        if (events != connection.events) {
+            epoll_event event{};
+            event.events = events;
+            event.data.u64 = id;
+            epoll_ctl(epoll, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.events = events;
+        }
+    }
+
+    void closeConnection(uint64_t id) {
+        auto it = connections.find(id);
+        if (it != connections.end()) {
+            close(it->second->fd);
+            connections.erase(it);
+        }
+    }
+
+    void acceptClients() {
+        while (true) {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return; // EAGAIN - очередь подключений пуста
+            }
+            uint64_t id = nextConnection++;
+            std::unique_ptr<Connection> connection(new Connection());
+            connection->fd = fd;
+            connection->events = EPOLLIN;
+            watch(fd, id, EPOLLIN);
+            connections.emplace(id, std::move(connection));
+            counters.connections++;
+        }
+    }
+
+    // Вычисление пачки строк в потоке пула
+    void evaluateBatch(uint64_t id, uint64_t batch, std::string& text) {
+        Completion completion{id, batch, takeBuffer(), 0, 0};
+        std::string_view rest = text;
+        while (!rest.empty()) {
+            size_t end = rest.find('\n');
+            std::string_view line = rest.substr(0, end);
+            rest.remove_prefix(end + 1);
+            completion.expressions++;
+            // Результат пишется сразу в буфер пачки, длина кадра - после него
+            std::string& frames = completion.frames;
+            size_t header = frames.size();
+            frames.append(FRAME_HEADER_BYTES, '\0');
+            if constexpr (IsEvaluationResult<decltype(evaluate(line))>::value) {
+                auto result = evaluate(line);
+                if (result) {
+                    appendNumber(frames, result.value(), FORMAT_BINARY);
+                } else {
+                    completion.failed++;
+                    frames += "Error: ";
+                    frames += result.error().message();
+                }
+            } else {
+                try {
+                    appendNumber(frames, evaluate(line), FORMAT_BINARY);
+                } catch (const std::exception& e) {
+                    completion.failed++;
+                    frames.resize(header + FRAME_HEADER_BYTES);
+                    frames += "Error: ";
+                    frames += e.what();
+                }
+            }
+            setFrameLength(frames, header);
+        }
+        returnBuffer(std::move(text));
+        complete(std::move(completion));
+    }
+
+    // Передача готовой пачки главному потоку
+    void complete(Completion&& completion) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed.push_back(std::move(completion));
+        }
+        uint64_t one = 1;
+        ssize_t result = write(wakeup, &one, sizeof(one));
+        (void)result;
+    }
+
+    // Чтение из сокета; целые строки уходят в пул одной пачкой
+    void readClient(uint64_t id, Connection& connection, WorkStealingPool& pool) {
+        std::string batch = takeBuffer();
+        batch.swap(connection.input);
+        size_t start = batch.size();
+        batch.resize(start + READ_BYTES);
+        ssize_t count;
+        do {
+            count = recv(connection.fd, &batch[start], READ_BYTES, 0);
+        } while (count < 0 && errno == EINTR);
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            count = 0;
+        } else if (count <= 0) {
+            // Конец запросов: последняя строка может быть без '\n'
+            connection.peerClosed = true;
+            count = 0;
+            if (start > 0 && batch[start - 1] != '\n') {
+                batch[start++] = '\n';
+            }
+        }
+        batch.resize(start + static_cast<size_t>(count));
+        counters.bytesIn += static_cast<size_t>(count);
+        if (connection.skipping) {
+            // Конец слишком длинной строки (пока пропускается, input пуст)
+            size_t newline = batch.find('\n');
+            connection.skipping = newline == std::string::npos;
+            batch.erase(0, connection.skipping ? batch.size() : newline + 1);
+        }
+
+        size_t end = batch.rfind('\n');
+        size_t lines = end == std::string::npos ? 0 : end + 1;
+        connection.input.assign(batch, lines, std::string::npos);
+        batch.resize(lines);
+        bool tooLong = connection.input.size() > MAX_LINE_BYTES;
+        if (tooLong) {
+            connection.input.clear();
+            connection.input.shrink_to_fit();
+            connection.skipping = true;
+        }
+        if (lines == 0) {
+            returnBuffer(std::move(batch));
+        } else {
+            uint64_t number = connection.nextBatch++;
+            std::shared_ptr<std::string> text = std::make_shared<std::string>(std::move(batch));
+            pool.submit([this, id, number, text] { evaluateBatch(id, number, *text); });
+        }
+        if (tooLong) {
+            // Ответ на длинную строку - отдельная пачка после строк перед ней
+            Completion completion{id, connection.nextBatch++, std::string(), 1, 1};
+            appendFrame(completion.frames, "Error: Line is too long");
+            complete(std::move(completion));
+        }
+    }
+
+    // Отправка накопленных кадров без блокировки
+    void writeClient(Connection& connection) {
+        while (connection.written < connection.output.size()) {
+            ssize_t count = send(connection.fd, connection.output.data() + connection.written,
+                                 connection.output.size() - connection.written, MSG_NOSIGNAL);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    connection.peerClosed = true;
+                    connection.written = connection.output.size();
+                }
+                break;
+            }
+            connection.written += static_cast<size_t>(count);
+            counters.bytesOut += static_cast<size_t>(count);
+        }
+        if (connection.written == connection.output.size()) {
+            connection.output.clear();
+            connection.written = 0;
+        }
+    }
+
+    // Вывод вычисленных пачек в порядке их номеров в соединении
+    void deliverCompleted() {
+        uint64_t value;
+        ssize_t result = read(wakeup, &value, sizeof(value));
+        (void)result;
+        std::vector<Completion> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.swap(completed);
+        }
+        for (Completion& completion : batch) {
+            counters.expressions += completion.expressions;
+            counters.failed += completion.failed;
+            auto it = connections.find(completion.connection);
+            if (it == connections.end()) {
+                returnBuffer(std::move(completion.frames));
+                continue;
+            }
+            Connection& connection = *it->second;
+            connection.ready.emplace(completion.batch, std::move(completion.frames));
+            for (auto next = connection.ready.begin(); next != connection.ready.end() && next->first == connection.nextOutput;
+                 next = connection.ready.begin()) {
+                connection.output += next->second;
+                returnBuffer(std::move(next->second));
+                connection.ready.erase(next);
+                connection.nextOutput++;
+            }
+            writeClient(connection);
+            finish(completion.connection, connection);
+        }
+    }
+
+    // Закрытие соединения, если клиент ушел и все ответы отправлены,
+    // иначе обновление подписки
+    void finish(uint64_t id, Connection& connection) {
+        if (connection.peerClosed && connection.nextOutput == connection.nextBatch &&
+            connection.written == connection.output.size()) {
+            closeConnection(id);
+        } else {
+            updateEvents(id, connection);
+        }
+    }
+
+    void openSocket() {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Socket path is too long: " + path);
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        // Сокет, оставшийся от прошлого запуска, удаляется
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+            unlink(path.c_str());
+        }
+
+        listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0) {
+            throw systemError("Cannot create socket");
+        }
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            throw systemError("Cannot bind socket " + path);
+        }
+        if (listen(listener, SOMAXCONN) < 0) {
+            throw systemError("Cannot listen on socket " + path);
+        }
+    }
+
+public:
+    EvaluatorServer(std::string _path, Evaluate _evaluate, unsigned _threads = 0)
+        : path(std::move(_path)), evaluate(std::move(_evaluate)), threads(_threads) {}
+
+    ~EvaluatorServer() {
+        for (auto& entry : connections) {
+            close(entry.second->fd);
+        }
+        for (int fd : {listener, epoll, wakeup, signals}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        if (listener >= 0) {
+            unlink(path.c_str());
+        }
+    }
+
+    EvaluatorServer(const EvaluatorServer&) = delete;
+    EvaluatorServer& operator=(const EvaluatorServer&) = delete;
+
+    // Работа до SIGINT или SIGTERM
+    ServerStats run() {
+        // Сигналы блокируются до создания пула, чтобы их получал только signalfd
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGINT);
+        sigaddset(&mask, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+        signals = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (signals < 0 || wakeup < 0 || epoll < 0) {
+            throw systemError("Cannot set up event loop");
+        }
+        openSocket();
+
+        watch(listener, LISTENER, EPOLLIN);
+        watch(wakeup, WAKEUP, EPOLLIN);
+        watch(signals, SIGNALS, EPOLLIN);
+
+        // Пул создается последним и останавливается первым: задачи пользуются
+        // вычислителем и очередью готовых пачек
+        WorkStealingPool pool(threads);
+        std::vector<epoll_event> events(64);
+        bool stopping = false;
+        while (!stopping) {
+            int count = epoll_wait(epoll, events.data(), static_cast<int>(events.size()), -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw systemError("Event loop failed");
+            }
+            for (int i = 0; i < count; i++) {
+                uint64_t id = events[i].data.u64;
+                if (id == LISTENER) {
+                    acceptClients();
+                } else if (id == WAKEUP) {
+                    deliverCompleted();
+                } else if (id == SIGNALS) {
+                    stopping = true;
+                } else {
+                    auto it = connections.find(id);
+                    if (it == connections.end()) {
+                        continue;
+                    }
+                    Connection& connection = *it->second;
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                        // Клиент закрыл сокет целиком - ответы отправлять некуда
+                        closeConnection(id);
+                        continue;
+                    }
+                    if ((events[i].events & EPOLLIN) && !connection.peerClosed) {
+                        readClient(id, connection, pool);
+                    }
+                    if (events[i].events & EPOLLOUT) {
+                        writeClient(connection);
+                    }
+                    finish(id, connection);
+                }
+            }
+        }
+        return counters;
+    }
+};
+
+// Вывод статистики сервера
+inline void printServerStats(std::ostream& os, const ServerStats& stats) {
+    os << "Served " << stats.connections << " connections: " << stats.expressions << " expressions ("
+       << stats.failed << " failed), " << stats.bytesIn << " bytes in, " << stats.bytesOut << " bytes out" << std::endl;
+}
+
+// Запуск сервера с вычислителем evaluate на сокете path
+template <class Evaluate>
+ServerStats runServer(const std::string& path, Evaluate evaluate, unsigned threads = 0) {
+    EvaluatorServer<Evaluate> server(path, std::move(evaluate), threads);
+    return server.run();
+}
+
+#endif
+
+#endif
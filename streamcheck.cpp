@@ -0,0 +1,152 @@
+// Дифференциальная проверка потокового вычисления (streaming.h): случайные
+// выражения подаются StreamingEvaluator кусками случайной длины, результат
+// и ошибка (причина и смещение) должны совпасть с tryEvaluatePostfix на всем
+// выражении. В выражения вставляются длинные токены (числа с ведущими нулями,
+// числа с хвостом после цифр, неверные токены) длиннее STREAM_MAX_TOKEN_BYTES,
+// чтобы граница куска их разрезала. Посередине части выражений состояние
+// сохраняется в контрольную точку и восстанавливается в новом вычислителе.
+// Сборка: g++ -O2 -std=c++17 -pthread streamcheck.cpp -o streamcheck
+// Запуск: streamcheck [--count C] [--tokens N] [--seed S] [--checkpoint путь]
+#define POSTFIX_NO_MAIN
+#include "2.cpp"
+#undef POSTFIX_NO_MAIN
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "generator.h"
+#include "streaming.h"
+
+// Итоги проверки одного типа чисел
+struct StreamCheckResult {
+    size_t expressions = 0; // Проверено выражений
+    size_t errors = 0; // Выражений, закончившихся ошибкой
+    size_t mismatches = 0; // Расхождений с tryEvaluatePostfix
+};
+
+// Длинный токен вместо числа value: ведущие нули, хвост после цифр,
+// переполнение int или токен без цифр
+std::string longToken(const std::string& value, SplitMix64& random) {
+    size_t length = STREAM_MAX_TOKEN_BYTES - 8 + random.below(STREAM_MAX_TOKEN_BYTES);
+    switch (random.below(5)) {
+        case 0: return std::string(length, '0') + value;
+        case 1: return (random.below(2) ? "-" : "+") + std::string(length, '0') + value;
+        case 2: return value + std::string(length, random.below(2) ? 'x' : '7');
+        case 3: return std::string(length, '1');
+        default: return std::string(length, 'q');
+    }
+}
+
+// Выражение генератора с заменой части чисел длинными токенами и
+// случайными вставками, которые дают ошибки разных видов
+std::string mutate(const std::string& expression, SplitMix64& random) {
+    std::string text;
+    Tokenizer tokenizer(expression);
+    std::string_view token;
+    while (tokenizer.next(token)) {
+        std::string piece(token);
+        bool number = token[0] >= '0' && token[0] <= '9';
+        if (number && random.below(8) == 0) {
+            piece = longToken(piece, random);
+        } else if (random.below(40) == 0) {
+            piece += random.below(2) ? " ~" : " /";
+        }
+        text += piece;
+        // Разделители разной длины
+        text.append(1 + random.below(3), random.below(4) == 0 ? '\n' : ' ');
+    }
+    if (random.below(30) == 0) {
+        text += "1 ";
+    }
+    return text;
+}
+
+template <class Number>
+StreamCheckResult checkStreaming(const GeneratorOptions& options, size_t count, const std::string& checkpoint) {
+    StreamCheckResult result;
+    ExpressionGenerator generator(options);
+    SplitMix64 random(options.seed * 31 + 7);
+    std::string expression;
+    for (size_t i = 0; i < count; i++) {
+        generator.generate(expression);
+        std::string text = mutate(expression, random);
+        EvaluationResult<Number> expected = tryEvaluatePostfix<Number>(text);
+
+        // Куски от 1 байта до размера длинного токена
+        size_t maxChunk = random.below(2) ? 16 : 2 * STREAM_MAX_TOKEN_BYTES;
+        size_t saveAt = random.below(4) == 0 ? random.below(text.size() + 1) : text.size() + 1;
+        StreamingEvaluator<Number> evaluator;
+        size_t position = 0;
+        while (position < text.size()) {
+            size_t size = std::min(text.size() - position, 1 + random.below(maxChunk));
+            evaluator.feed(std::string_view(text).substr(position, size));
+            position += size;
+            if (position >= saveAt && !evaluator.failed()) {
+                evaluator.saveCheckpoint(checkpoint);
+                StreamingEvaluator<Number> restored;
+                restored.loadCheckpoint(checkpoint);
+                evaluator = std::move(restored);
+                saveAt = text.size() + 1;
+            }
+        }
+        EvaluationResult<Number> actual = evaluator.finish();
+
+        // Токен ошибки у потокового вычисления - начало токена (не длиннее STREAM_MAX_TOKEN_BYTES)
+        bool same = outcome(expected) == outcome(actual) &&
+                    (expected || expected.error().token.substr(0, actual.error().token.size()) == actual.error().token);
+        if (!same) {
+            if (result.mismatches < 5) {
+                std::cerr << "Mismatch (" << text.size() << " bytes): " << text.substr(0, 200)
+                          << "\n  expected " << outcome(expected) << "\n  streamed " << outcome(actual) << std::endl;
+            }
+            result.mismatches++;
+        }
+        result.errors += expected ? 0 : 1;
+        result.expressions++;
+    }
+    std::remove(checkpoint.c_str());
+    return result;
+}
+
+void printStreamCheck(const char* name, const StreamCheckResult& result) {
+    std::cout << std::left << std::setw(12) << name << std::right << result.expressions << " expressions, "
+              << result.errors << " errors, " << result.mismatches << " mismatches" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        GeneratorOptions options;
+        size_t count = 5000;
+        std::string checkpoint = "streamcheck.checkpoint";
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--count" && hasValue) count = std::stoull(argv[++i]);
+            else if (arg == "--tokens" && hasValue) options.tokens = std::stoull(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+            else if (arg == "--checkpoint" && hasValue) checkpoint = argv[++i];
+            else throw std::runtime_error("Unknown argument: " + arg);
+        }
+
+        // Большие литералы: длинная арифметика и переполнения
+        GeneratorOptions large = options;
+        large.maxValue = 127;
+
+        size_t mismatches = 0;
+        auto run = [&](const char* name, const StreamCheckResult& result) {
+            printStreamCheck(name, result);
+            mismatches += result.mismatches;
+        };
+        run("8 throw", checkStreaming<Binary<8, OVERFLOW_THROW>>(options, count, checkpoint));
+        run("32", checkStreaming<Binary32>(options, count, checkpoint));
+        run("big", checkStreaming<BigBinary>(large, count, checkpoint));
+        return mismatches == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
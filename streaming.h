@@ -0,0 +1,384 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "bigbinary.h"
+#include "binary.h"
+#include "evaluation.h"
+#include "memo.h"
+#include "operators.h"
+#include "tokenizer.h"
+
+// Объем одного куска при чтении выражения
+const size_t STREAM_CHUNK_BYTES = 1 << 20;
+// Через сколько байт входа сохраняется контрольная точка
+const uint64_t STREAM_CHECKPOINT_BYTES = 256ULL << 20;
+// Наибольшая хранимая длина токена, разрезанного границей куска. Более
+// длинный токен не операция; его число разбирается по мере поступления
+// байтов (как parseInt), а от неверного токена в сообщении остается начало.
+const size_t STREAM_MAX_TOKEN_BYTES = 4096;
+// Первая строка файла контрольной точки
+const char STREAM_CHECKPOINT_HEADER[] = "postfix-checkpoint 2";
+
+// Состояние разбора числа в длинном разрезанном токене
+enum StreamNumberState {
+    STREAM_NUMBER_START, // Ничего не прочитано
+    STREAM_NUMBER_SIGN, // Прочитан знак
+    STREAM_NUMBER_DIGITS, // Идут цифры
+    STREAM_NUMBER_DONE, // Число закончилось, остаток токена не важен
+    STREAM_NUMBER_INVALID // Цифр нет или число не помещается в int
+};
+
+// Число из десятичной записи в контрольной точке
+template <int N, OverflowPolicy POLICY>
+void parseCheckpointNumber(const std::string& text, Binary<N, POLICY>& result) {
+    result = Binary<N, POLICY>(std::stoll(text));
+}
+
+// Для BigBinary - по 9 цифр за шаг
+inline void parseCheckpointNumber(const std::string& text, BigBinary& result) {
+    size_t i = !text.empty() && text[0] == '-' ? 1 : 0;
+    if (i == text.size()) {
+        throw std::runtime_error("Invalid checkpoint number: " + text);
+    }
+    BigBinary value;
+    while (i < text.size()) {
+        size_t digits = std::min<size_t>(9, text.size() - i);
+        long long scale = 1;
+        for (size_t k = 0; k < digits; k++) {
+            scale *= 10;
+        }
+        value = value * BigBinary(scale) + BigBinary(std::stoll(text.substr(i, digits)));
+        i += digits;
+    }
+    result = text[0] == '-' ? -value : value;
+}
+
+// Вычисление одного постфиксного выражения, которое приходит кусками
+// произвольного размера: граница куска может разрезать токен. Хранится только
+// стек операндов и начало незаконченного токена, поэтому память зависит от
+// глубины стека, а не от длины выражения. Состояние между кусками можно
+// сохранить в файл контрольной точки и позже продолжить с того же места.
+// Ошибки и их места те же, что у tryEvaluatePostfix на всем выражении.
+template <class Number>
+class StreamingEvaluator {
+    std::vector<Number> stack; // Стек операндов
+    std::string partial; // Начало токена, разрезанного границей куска
+    bool inToken = false; // Последний кусок закончился внутри токена
+    uint64_t partialOffset = 0; // Смещение этого токена от начала выражения
+    uint64_t partialLength = 0; // Полная длина этого токена
+    int numberState = STREAM_NUMBER_START; // Разбор числа этого токена (StreamNumberState)
+    bool numberNegative = false; // Знак числа
+    long long numberMagnitude = 0; // Модуль числа
+    uint64_t position = 0; // Принято байт выражения
+    uint64_t tokens = 0; // Обработано токенов
+    size_t maxDepth = 0; // Наибольшая глубина стека
+    EvaluationErrorCode failure = EVALUATION_OK; // Первая ошибка
+    uint64_t failureOffset = 0; // Смещение токена с ошибкой
+    std::string failureToken; // Токен с ошибкой (копия: куска уже нет)
+
+    void fail(EvaluationErrorCode code, std::string_view token, uint64_t offset) {
+        failure = code;
+        failureOffset = offset;
+        failureToken.assign(token.data(), std::min(token.size(), STREAM_MAX_TOKEN_BYTES));
+    }
+
+    // Обработка одного целого токена
+    void processToken(std::string_view token, uint64_t offset) {
+        tokens++;
+        char op = binaryOperatorCode(token);
+        if (op != 0) {
+            if (stack.size() < 2) return fail(EVALUATION_STACK_UNDERFLOW, token, offset);
+            Number result;
+            EvaluationErrorCode code = tryApplyBinaryOperator(op, stack[stack.size() - 2], stack.back(), result);
+            if (code != EVALUATION_OK) return fail(code, token, offset);
+            stack.pop_back();
+            stack.back() = std::move(result);
+        } else if (isNotOperator(token)) {
+            if (stack.empty()) return fail(EVALUATION_STACK_UNDERFLOW, token, offset);
+            stack.back() = ~stack.back();
+        } else {
+            int value;
+            if (!parseInt(token, value)) return fail(EVALUATION_BAD_TOKEN, token, offset);
+            pushNumber(value, token, offset);
+        }
+    }
+
+    // Число на стек (или ошибка, если оно не представимо в Number)
+    void pushNumber(int value, std::string_view token, uint64_t offset) {
+        Number number;
+        EvaluationErrorCode code = tryMakeNumber(value, number);
+        if (code != EVALUATION_OK) return fail(code, token, offset);
+        stack.push_back(std::move(number));
+        maxDepth = std::max(maxDepth, stack.size());
+    }
+
+    // Разбор числа по очередному куску разрезанного токена по правилам parseInt
+    void scanNumber(std::string_view text) {
+        long long limit = numberNegative ? -static_cast<long long>(INT_MIN) : INT_MAX;
+        for (char c : text) {
+            if (numberState == STREAM_NUMBER_DONE || numberState == STREAM_NUMBER_INVALID) {
+                return;
+            }
+            bool digit = c >= '0' && c <= '9';
+            if (numberState == STREAM_NUMBER_START && (c == '+' || c == '-')) {
+                numberNegative = c == '-';
+                limit = numberNegative ? -static_cast<long long>(INT_MIN) : INT_MAX;
+                numberState = STREAM_NUMBER_SIGN;
+            } else if (!digit) {
+                numberState = numberState == STREAM_NUMBER_DIGITS ? STREAM_NUMBER_DONE : STREAM_NUMBER_INVALID;
+            } else {
+                numberState = STREAM_NUMBER_DIGITS;
+                numberMagnitude = numberMagnitude * 10 + (c - '0');
+                if (numberMagnitude > limit) {
+                    numberState = STREAM_NUMBER_INVALID;
+                }
+            }
+        }
+    }
+
+    // Продолжение разрезанного токена. Хранится не больше STREAM_MAX_TOKEN_BYTES
+    // байт, число разбирается по всем байтам
+    void appendPartial(std::string_view text) {
+        size_t room = STREAM_MAX_TOKEN_BYTES - partial.size();
+        partial.append(text.data(), std::min(room, text.size()));
+        partialLength += text.size();
+        scanNumber(text);
+    }
+
+    // Обработка токена, собранного из нескольких кусков. Длинный токен не
+    // разбирается по обрезанному началу: берется число, разобранное по всем байтам
+    void finishPartial() {
+        inToken = false;
+        if (partialLength <= STREAM_MAX_TOKEN_BYTES) {
+            processToken(partial, partialOffset);
+        } else if (numberState == STREAM_NUMBER_DIGITS || numberState == STREAM_NUMBER_DONE) {
+            tokens++;
+            pushNumber(static_cast<int>(numberNegative ? -numberMagnitude : numberMagnitude), partial, partialOffset);
+        } else {
+            tokens++;
+            fail(EVALUATION_BAD_TOKEN, partial, partialOffset);
+        }
+        partial.clear();
+        partialLength = 0;
+        numberState = STREAM_NUMBER_START;
+        numberNegative = false;
+        numberMagnitude = 0;
+    }
+
+public:
+    // Прием очередного куска выражения; false, если в выражении уже есть ошибка
+    // (остальные куски после ошибки только считаются)
+    bool feed(std::string_view chunk) {
+        uint64_t start = position;
+        position += chunk.size();
+        if (failure != EVALUATION_OK) {
+            return false;
+        }
+        size_t i = 0;
+        if (inToken) {
+            while (i < chunk.size() && !isSpace(chunk[i])) {
+                i++;
+            }
+            appendPartial(chunk.substr(0, i));
+            if (i == chunk.size()) {
+                return true;
+            }
+            finishPartial();
+        }
+        Tokenizer tokenizer(chunk.substr(i));
+        std::string_view token;
+        while (failure == EVALUATION_OK && tokenizer.next(token)) {
+            size_t offset = static_cast<size_t>(token.data() - chunk.data());
+            if (offset + token.size() == chunk.size()) {
+                // Токен может продолжиться в следующем куске
+                inToken = true;
+                partialOffset = start + offset;
+                appendPartial(token);
+                break;
+            }
+            processToken(token, start + offset);
+        }
+        return failure == EVALUATION_OK;
+    }
+
+    // Конец выражения: результат или ошибка. Токен ошибки указывает
+    // во внутреннюю строку и действителен до следующего изменения объекта.
+    EvaluationResult<Number> finish() {
+        if (failure == EVALUATION_OK && inToken) {
+            finishPartial();
+        }
+        if (failure == EVALUATION_OK && stack.empty()) {
+            fail(EVALUATION_STACK_UNDERFLOW, std::string_view(), position);
+        } else if (failure == EVALUATION_OK && stack.size() > 1) {
+            fail(EVALUATION_LEFTOVER_OPERANDS, std::string_view(), position);
+        }
+        if (failure != EVALUATION_OK) {
+            return EvaluationError{failure, static_cast<size_t>(failureOffset), failureToken};
+        }
+        return stack.back();
+    }
+
+    // Начало нового выражения
+    void reset() {
+        *this = StreamingEvaluator();
+    }
+
+    // Принято байт выражения (с этого места продолжается чтение после восстановления)
+    uint64_t consumed() const {
+        return position;
+    }
+
+    uint64_t tokenCount() const {
+        return tokens;
+    }
+
+    size_t depth() const {
+        return stack.size();
+    }
+
+    size_t maxStackDepth() const {
+        return maxDepth;
+    }
+
+    bool failed() const {
+        return failure != EVALUATION_OK;
+    }
+
+    // Сохранение состояния в файл. Запись идет во временный файл, который
+    // затем заменяет старую точку, поэтому прерванная запись ее не портит.
+    void saveCheckpoint(const std::string& path) const {
+        if (failure != EVALUATION_OK) {
+            throw std::runtime_error("Cannot checkpoint a failed expression");
+        }
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Cannot open file: " + temporary);
+            }
+            out << STREAM_CHECKPOINT_HEADER << ' ' << NumericSemantics<Number>::TAG << '\n'
+                << "position " << position << ' ' << tokens << ' ' << maxDepth << '\n'
+                << "number " << partialLength << ' ' << numberState << ' ' << (numberNegative ? 1 : 0) << ' '
+                << numberMagnitude << '\n'
+                << "token " << (inToken ? 1 : 0) << ' ' << partialOffset << ' ' << partial << '\n'
+                << "stack " << stack.size() << '\n';
+            for (const Number& value : stack) {
+                out << value.decimal() << '\n';
+            }
+            out.flush();
+            if (!out) {
+                throw std::runtime_error("Cannot write file: " + temporary);
+            }
+        }
+#ifdef _WIN32
+        std::remove(path.c_str()); // rename в Windows не заменяет существующий файл
+#endif
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Cannot write file: " + path);
+        }
+    }
+
+    // Восстановление состояния из файла, сохраненного saveCheckpoint для того же типа чисел
+    void loadCheckpoint(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        std::string header, word;
+        size_t size = 0;
+        int hasToken = 0;
+        StreamingEvaluator restored;
+        // Заголовок с тегом типа чисел: точка другого типа не подходит
+        std::getline(in, header);
+        if (header != std::string(STREAM_CHECKPOINT_HEADER) + ' ' + std::to_string(NumericSemantics<Number>::TAG)) {
+            throw std::runtime_error("Invalid checkpoint: " + path);
+        }
+        int negative = 0;
+        in >> word >> restored.position >> restored.tokens >> restored.maxDepth
+           >> word >> restored.partialLength >> restored.numberState >> negative >> restored.numberMagnitude
+           >> word >> hasToken >> restored.partialOffset;
+        restored.numberNegative = negative != 0;
+        // Токен не содержит пробелов: он идет после одного пробела до конца строки
+        in.get();
+        std::getline(in, restored.partial);
+        restored.inToken = hasToken != 0;
+        in >> word >> size;
+        restored.stack.resize(size);
+        for (Number& value : restored.stack) {
+            in >> word;
+            parseCheckpointNumber(word, value);
+        }
+        if (!in) {
+            throw std::runtime_error("Invalid checkpoint: " + path);
+        }
+        *this = std::move(restored);
+    }
+};
+
+// Потоковое вычисление выражения из in кусками по STREAM_CHUNK_BYTES.
+// Если задан путь checkpoint, каждые STREAM_CHECKPOINT_BYTES входа состояние
+// сохраняется в этот файл, а если файл уже есть - вычисление продолжается
+// с сохраненного места (начало входа пропускается). После конца выражения
+// файл удаляется.
+template <class Number>
+EvaluationResult<Number> evaluateStream(std::istream& in, StreamingEvaluator<Number>& evaluator,
+                                        const std::string& checkpoint = std::string()) {
+    std::vector<char> buffer(STREAM_CHUNK_BYTES);
+    if (!checkpoint.empty() && std::ifstream(checkpoint)) {
+        evaluator.loadCheckpoint(checkpoint);
+        // Пропуск уже вычисленной части входа
+        for (uint64_t skip = evaluator.consumed(); skip > 0;) {
+            in.read(buffer.data(), static_cast<std::streamsize>(std::min<uint64_t>(skip, buffer.size())));
+            if (in.gcount() == 0) {
+                throw std::runtime_error("Input is shorter than the checkpoint");
+            }
+            skip -= static_cast<uint64_t>(in.gcount());
+        }
+    }
+    uint64_t nextCheckpoint = evaluator.consumed() + STREAM_CHECKPOINT_BYTES;
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        size_t count = static_cast<size_t>(in.gcount());
+        if (!evaluator.feed(std::string_view(buffer.data(), count))) {
+            break;
+        }
+        if (!checkpoint.empty() && evaluator.consumed() >= nextCheckpoint) {
+            evaluator.saveCheckpoint(checkpoint);
+            nextCheckpoint = evaluator.consumed() + STREAM_CHECKPOINT_BYTES;
+        }
+    }
+    EvaluationResult<Number> result = evaluator.finish();
+    if (!checkpoint.empty()) {
+        std::remove(checkpoint.c_str());
+    }
+    return result;
+}
+
+// Потоковое вычисление выражения из файла или, если имя файла пустое,
+// из стандартного ввода
+template <class Number>
+EvaluationResult<Number> evaluateStreamInput(const std::string& inputFile, StreamingEvaluator<Number>& evaluator,
+                                             const std::string& checkpoint = std::string()) {
+    if (inputFile.empty()) {
+        return evaluateStream(std::cin, evaluator, checkpoint);
+    }
+    std::ifstream in(inputFile, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open file: " + inputFile);
+    }
+    return evaluateStream(in, evaluator, checkpoint);
+}
+
+#endif
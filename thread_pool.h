@@ -0,0 +1,166 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом работы (work stealing).
+// У каждого рабочего потока своя очередь задач: свои задачи он берет с конца
+// очереди, а когда она пуста - крадет самые старые задачи из начала чужих очередей.
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+private:
+    // Очередь задач одного рабочего потока
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // Очереди рабочих потоков
+    std::vector<std::thread> workers; // Рабочие потоки
+    std::atomic<size_t> nextQueue; // Очередь для следующей задачи извне пула
+    std::atomic<size_t> pending; // Количество задач, еще не взятых в работу
+    std::mutex sleepMutex; // Мьютекс для ожидания новых задач
+    std::condition_variable wake; // Сигнал о появлении задач или остановке
+    bool stopping; // Флаг остановки пула
+
+    // Пул и номер рабочего потока, которым является текущий поток
+    struct WorkerSlot {
+        const WorkStealingPool* pool = nullptr;
+        int index = -1;
+    };
+
+    static WorkerSlot& workerSlot() {
+        thread_local WorkerSlot slot;
+        return slot;
+    }
+
+    // Номер рабочего потока этого пула (или -1 для чужих потоков)
+    int currentWorker() const {
+        const WorkerSlot& slot = workerSlot();
+        return slot.pool == this ? slot.index : -1;
+    }
+
+    // Попытка взять задачу: сначала из своей очереди, затем украсть из чужой
+    bool tryPop(size_t self, Task& task) {
+        {
+            Queue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                pending--;
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); i++) {
+            Queue& victim = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                pending--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Цикл рабочего потока
+    void workerLoop(size_t self) {
+        workerSlot().pool = this;
+        workerSlot().index = static_cast<int>(self);
+        Task task;
+        while (true) {
+            if (tryPop(self, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || pending > 0; });
+            if (stopping && pending == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    // Конструктор: threads = 0 - по числу аппаратных потоков
+    explicit WorkStealingPool(unsigned threads = 0) : nextQueue(0), pending(0), stopping(false) {
+        if (threads == 0) {
+            threads = defaultThreads();
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            queues.emplace_back(new Queue());
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+    }
+
+    // Деструктор: дожидается выполнения всех задач и останавливает потоки
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Число аппаратных потоков (не меньше одного)
+    static unsigned defaultThreads() {
+        unsigned threads = std::thread::hardware_concurrency();
+        return threads == 0 ? 1 : threads;
+    }
+
+    // Количество рабочих потоков
+    size_t size() const {
+        return workers.size();
+    }
+
+    // Выполнение одной ожидающей задачи текущим потоком: рабочий поток берет
+    // сначала из своей очереди, чужой поток - из любой. Нужно для ожидания
+    // вложенных задач без блокировки (fork-join); false - задач нет
+    bool runPendingTask() {
+        int self = currentWorker();
+        Task task;
+        if (!tryPop(self >= 0 ? static_cast<size_t>(self) : 0, task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+    // Добавление задачи: из рабочего потока - в его очередь, иначе по кругу
+    void submit(Task task) {
+        int self = currentWorker();
+        size_t index = self >= 0 ? static_cast<size_t>(self) : nextQueue++ % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            pending++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <climits>
+#include <cstddef>
+#include <string_view>
+#include "instrument.h"
+
+// Проверка символа-разделителя (те же символы, что у isspace в локали "C")
+constexpr bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// Разбиение выражения на токены без копирования: каждый токен - это
+// std::string_view на байты исходного текста
+class Tokenizer {
+    std::string_view text; // Разбираемый текст
+    size_t pos; // Позиция начала непрочитанной части
+
+public:
+    // Конструктор по тексту выражения
+    explicit Tokenizer(std::string_view _text) : text(_text), pos(0) {}
+
+    // Получение следующего токена; false, если токены закончились
+    bool next(std::string_view& token) {
+        INSTRUMENT_PHASE(tokenizeNanos);
+        while (pos < text.size() && isSpace(text[pos])) {
+            pos++;
+        }
+        if (pos == text.size()) {
+            return false;
+        }
+        size_t start = pos;
+        while (pos < text.size() && !isSpace(text[pos])) {
+            pos++;
+        }
+        token = text.substr(start, pos - start);
+        INSTRUMENT_COUNT(tokens);
+        return true;
+    }
+
+    // Смещение начала непрочитанной части от начала текста
+    size_t offset() const {
+        return pos;
+    }
+};
+
+// Разбор целого числа в начале токена так же, как это делает std::stoi:
+// необязательный знак, хотя бы одна цифра, остаток токена игнорируется.
+// Возвращает false, если цифр нет или число не помещается в int.
+// Без замера времени, поэтому годится и для вычисления при компиляции.
+constexpr bool parseIntConstant(std::string_view token, int& value) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < token.size() && (token[i] == '+' || token[i] == '-')) {
+        negative = token[i] == '-';
+        i++;
+    }
+    if (i == token.size() || token[i] < '0' || token[i] > '9') {
+        return false;
+    }
+    // Модуль накапливается в long long, граница - INT_MAX или |INT_MIN|
+    long long limit = negative ? -static_cast<long long>(INT_MIN) : INT_MAX;
+    long long magnitude = 0;
+    for (; i < token.size() && token[i] >= '0' && token[i] <= '9'; i++) {
+        magnitude = magnitude * 10 + (token[i] - '0');
+        if (magnitude > limit) {
+            return false;
+        }
+    }
+    value = static_cast<int>(negative ? -magnitude : magnitude);
+    return true;
+}
+
+// То же с замером времени разбора (instrument.h)
+inline bool parseInt(std::string_view token, int& value) {
+    INSTRUMENT_PHASE(tokenizeNanos);
+    return parseIntConstant(token, value);
+}
+
+#endif